@@ -0,0 +1,139 @@
+/**
+ * Standalone benchmark of the shared memory layer of memshare (no R needed).
+ *
+ * Measures for a sweep of segment sizes:
+ *   alloc     creating the data and metadata segments of a variable (MemoryPage::alloc),
+ *   fill      copying the payload into the data segment,
+ *   attach    mapping both segments as a viewer (MemoryPage::view), in this and in a forked process,
+ *   scan      reading every element through the view (first touch of the mapping),
+ *   release   unmapping the view and unlinking the owned segments.
+ *
+ * SharedData (src/shared_memory.cpp) converts R objects and cannot be linked without R; the harness therefore
+ * reproduces its layout (one metadata segment plus one data segment per variable) with MemoryPage directly.
+ * The R level costs are covered by benchmark.R.
+ *
+ * Build and run from this directory:
+ *   g++ -O2 -std=c++17 -I../../src memory_page_bench.cpp ../../src/memory_page.cpp -o memory_page_bench -lrt
+ *   ./memory_page_bench [reps] [output.csv]
+ *
+ * Each repetition writes one line "size_bytes,rep,phase,seconds" to the output (default stdout).
+ */
+
+#include "memory_page.h"
+#include "segment_header.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <sys/wait.h>
+#endif
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double seconds_since(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+// size of the metadata segment of a matrix or vector: header followed by one metadata struct (see metadata.h)
+const std::size_t META_BYTES = SEGMENT_HEADER_BYTES + 3 * sizeof(std::size_t);
+
+void report(FILE* out, std::size_t bytes, int rep, const char* phase, double secs) {
+    std::fprintf(out, "%zu,%d,%s,%.9f\n", bytes, rep, phase, secs);
+}
+
+// attach to a variable, scan it and return the sum so that the compiler cannot drop the reads
+double attach_and_scan(const std::string& name, std::size_t bytes, double& attachSecs, double& scanSecs) {
+    Clock::time_point start = Clock::now();
+    MemoryPage meta, mem;
+    meta.view(name + ".md", META_BYTES);
+    mem.view(name, bytes);
+    attachSecs = seconds_since(start);
+
+    start = Clock::now();
+    const double* p = mem.data();
+    double sum = 0;
+    for (std::size_t i = 0; i < bytes / sizeof(double); i++) sum += p[i];
+    scanSecs = seconds_since(start);
+    return sum;
+}
+
+void run(FILE* out, std::size_t bytes, int rep) {
+    std::string name = "/membench." + std::to_string(bytes) + "." + std::to_string(rep);
+    std::vector<double> payload(bytes / sizeof(double), 1.0);
+
+    Clock::time_point start = Clock::now();
+    MemoryPage* meta = new MemoryPage();
+    MemoryPage* mem = new MemoryPage();
+    meta->alloc(name + ".md", META_BYTES);
+    mem->alloc(name, bytes);
+    report(out, bytes, rep, "alloc", seconds_since(start));
+
+    start = Clock::now();
+    std::memcpy(mem->data(), payload.data(), bytes);
+    report(out, bytes, rep, "fill", seconds_since(start));
+
+    double attachSecs = 0, scanSecs = 0;
+    double sum = attach_and_scan(name, bytes, attachSecs, scanSecs);
+    if (sum != static_cast<double>(payload.size())) std::fprintf(stderr, "checksum mismatch for %s\n", name.c_str());
+    report(out, bytes, rep, "attach", attachSecs);
+    report(out, bytes, rep, "scan", scanSecs);
+
+#ifndef _WIN32
+    // a second process mapping the segment, as a worker of memApply/memLapply would
+    int fds[2];
+    if (pipe(fds) == 0) {
+        pid_t pid = fork();
+        if (pid == 0) {
+            close(fds[0]);
+            double secs[2] = {0, 0};
+            attach_and_scan(name, bytes, secs[0], secs[1]);
+            ssize_t written = write(fds[1], secs, sizeof(secs));
+            _exit(written == sizeof(secs) ? 0 : 1);
+        }
+        close(fds[1]);
+        double secs[2] = {0, 0};
+        if (pid > 0 && read(fds[0], secs, sizeof(secs)) == sizeof(secs)) {
+            report(out, bytes, rep, "attach_worker", secs[0]);
+            report(out, bytes, rep, "scan_worker", secs[1]);
+        }
+        close(fds[0]);
+        if (pid > 0) waitpid(pid, nullptr, 0);
+    }
+#endif
+
+    start = Clock::now();
+    delete mem;
+    delete meta;
+    report(out, bytes, rep, "release", seconds_since(start));
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int reps = argc > 1 ? std::atoi(argv[1]) : 5;
+    FILE* out = argc > 2 ? std::fopen(argv[2], "w") : stdout;
+    if (reps <= 0 || out == nullptr) {
+        std::fprintf(stderr, "usage: %s [reps] [output.csv]\n", argv[0]);
+        return 1;
+    }
+
+    const std::size_t sizes[] = {1u << 10, 1u << 16, 1u << 20, 1u << 24, 1u << 28};
+    std::fprintf(out, "size_bytes,rep,phase,seconds\n");
+    try {
+        for (std::size_t bytes : sizes) {
+            for (int rep = 0; rep < reps; rep++) run(out, bytes, rep);
+        }
+    } catch (std::exception& e) {
+        std::fprintf(stderr, "memory_page_bench: %s\n", e.what());
+        return 1;
+    }
+    if (out != stdout) std::fclose(out);
+    return 0;
+}
@@ -1,14 +1,131 @@
 #include "altrep.h"
+#include "memory_page.h"
 #include <iostream>
 #include <Rcpp.h>
+#include <algorithm>
+#include <cstring>
+#include <memory>
+
+namespace {
+    void delete_source(SEXP p) {
+        delete static_cast<PageSource*>(R_ExternalPtrAddr(p));
+        R_ClearExternalPtr(p);
+    }
+
+    void delete_mapping(SEXP p) {
+        delete static_cast<MemoryPage*>(R_ExternalPtrAddr(p));
+        R_ClearExternalPtr(p);
+    }
+
+    SEXP source_pointer(const PageSource* source) {
+        if (source == nullptr) return R_NilValue;
+        SEXP p = PROTECT(R_MakeExternalPtr(new PageSource(*source), R_NilValue, R_NilValue));
+        R_RegisterCFinalizerEx(p, delete_source, TRUE);
+        UNPROTECT(1);
+        return p;
+    }
+
+    // The doubles of a matrix or vector ALTREP whose info holds the data ptr first, the writable flag at index flag and
+    // the source of the data at index source. The pages of a view are mapped read-only (or shared with all processes,
+    // for arenas), hence a write request of a view that is not copy-on-write maps the data privately once more: its
+    // pages are shared with the section until they are written. Without a source it gets a copy in R memory. Either is
+    // kept in data2 and used from then on.
+    void* altrep_real_dataptr(SEXP x, int flag, int source, R_xlen_t len, Rboolean writeable) {
+        SEXP copy = R_altrep_data2(x);
+        if (copy != R_NilValue) {
+            if (TYPEOF(copy) == EXTPTRSXP) return (void*) static_cast<MemoryPage*>(R_ExternalPtrAddr(copy))->data();
+            return (void*) REAL(copy);
+        }
+        SEXP info = R_altrep_data1(x);
+        double* ptr = (double*) R_ExternalPtrAddr(VECTOR_ELT(info, 0));
+        if (!writeable || LOGICAL(VECTOR_ELT(info, flag))[0]) return (void*) ptr;
+
+        if (VECTOR_ELT(info, source) != R_NilValue) {
+            std::unique_ptr<MemoryPage> page(new MemoryPage());
+            try {
+                page->map_private(*static_cast<PageSource*>(R_ExternalPtrAddr(VECTOR_ELT(info, source))),
+                                  static_cast<size_t>(len) * sizeof(double));
+            } catch (std::runtime_error&) {
+                // the section is gone (e.g. released by its owner), the copy below still reads the mapped view
+                page.reset();
+            }
+            if (page) {
+                copy = PROTECT(R_MakeExternalPtr(page.get(), R_NilValue, R_NilValue));
+                R_RegisterCFinalizerEx(copy, delete_mapping, TRUE);
+                double* data = page.release()->data();
+                R_set_altrep_data2(x, copy);
+                UNPROTECT(1);
+                return (void*) data;
+            }
+        }
+
+        copy = PROTECT(Rf_allocVector(REALSXP, len));
+        std::memcpy(REAL(copy), ptr, static_cast<size_t>(len) * sizeof(double));
+        R_set_altrep_data2(x, copy);
+        UNPROTECT(1);
+        return (void*) REAL(copy);
+    }
+
+    // The column statistics of an ALTREP whose info holds them at index and the header of their page behind; nullptr
+    // if there are none, an update made them stale or the ALTREP uses a private mapping or copy by now.
+    const ColumnStats* altrep_stats(SEXP x, int index) {
+        if (R_altrep_data2(x) != R_NilValue) return nullptr;
+        SEXP info = R_altrep_data1(x);
+        if (VECTOR_ELT(info, index) == R_NilValue) return nullptr;
+        const SegmentHeader* h = (const SegmentHeader*) R_ExternalPtrAddr(VECTOR_ELT(info, index + 1));
+        if (h == nullptr || !h->stats_valid.load()) return nullptr;
+        return (const ColumnStats*) R_ExternalPtrAddr(VECTOR_ELT(info, index));
+    }
+
+    enum summary { SUM, MIN, MAX };
+
+    // sum, min or max of ncol columns from their statistics; NULL if they do not tell it. The sum adds up the stored
+    // column sums, hence it may differ from the sum R computes over the elements in the last bits.
+    SEXP stats_summary(const ColumnStats* stats, size_t nrow, size_t ncol, Rboolean narm, summary what) {
+        if (stats == nullptr) return NULL;
+        long double sum = 0;
+        double lo = R_PosInf, hi = R_NegInf;
+        bool any = false;
+        for (size_t j = 0; j < ncol; j++) {
+            // NAs without na.rm make the result NA or NaN, depending on which comes first
+            if (stats[j].na_count > 0 && !narm) return NULL;
+            if (stats[j].na_count == nrow) continue;
+            any = true;
+            sum += stats[j].sum;
+            if (stats[j].min < lo) lo = stats[j].min;
+            if (stats[j].max > hi) hi = stats[j].max;
+        }
+        if (what == SUM) return Rf_ScalarReal(static_cast<double>(sum));
+        // R warns about the empty case itself
+        if (!any) return NULL;
+        return Rf_ScalarReal(what == MIN ? lo : hi);
+    }
+
+    int stats_no_na(const ColumnStats* stats, size_t ncol) {
+        if (stats == nullptr) return 0;
+        for (size_t j = 0; j < ncol; j++) {
+            if (stats[j].na_count > 0) return 0;
+        }
+        return 1;
+    }
+
+    SEXP stats_pointer(const ColumnStats* stats) {
+        return stats == nullptr ? R_NilValue : R_MakeExternalPtr(const_cast<ColumnStats*>(stats), R_NilValue, R_NilValue);
+    }
+}
 
 extern "C" {
-    SEXP make_altrep_matrix(double* ptr, size_t nrow, size_t ncol) {
-        // Allocate a vector under PROTECT with 3 elements for the metadata
-        SEXP info = PROTECT(Rf_allocVector(VECSXP, 3));
+    SEXP make_altrep_matrix(double* ptr, size_t nrow, size_t ncol, bool writable, const ColumnStats* stats, SegmentHeader* header,
+                            const PageSource* source) {
+        // Allocate a vector under PROTECT with 7 elements for the metadata
+        SEXP info = PROTECT(Rf_allocVector(VECSXP, 7));
         SET_VECTOR_ELT(info, 0, R_MakeExternalPtr(ptr, R_NilValue, R_NilValue)); // data ptr
         SET_VECTOR_ELT(info, 1, Rf_ScalarInteger(nrow)); // nrow
         SET_VECTOR_ELT(info, 2, Rf_ScalarInteger(ncol)); // ncol
+        SET_VECTOR_ELT(info, 3, Rf_ScalarLogical(writable)); // copy-on-write view
+        SET_VECTOR_ELT(info, 4, stats_pointer(stats)); // column statistics
+        SET_VECTOR_ELT(info, 5, R_MakeExternalPtr(header, R_NilValue, R_NilValue)); // their validity
+        SET_VECTOR_ELT(info, 6, source_pointer(source)); // for a private mapping
 
         // Now we allocate a new ALTREP matrix object and associate to it the metadata from above used from R-side to determine that this is a matrix.
         SEXP alt_vec = PROTECT(R_new_altrep(altrep_matrix_class, info, R_NilValue));
@@ -46,20 +163,39 @@ extern "C" {
 
     void* altrep_matrix_dataptr(SEXP x, Rboolean writeable) {
         // retrieve the data ptr from the metadata
-        SEXP info = R_altrep_data1(x);
-        double* ptr = (double*) R_ExternalPtrAddr(VECTOR_ELT(info, 0));
-        return (void*) ptr;
+        return altrep_real_dataptr(x, 3, 6, altrep_matrix_length(x), writeable);
     }
 
     const void* altrep_matrix_dataptr_or_null(SEXP x) {
-        return (const void*) altrep_matrix_dataptr(x, TRUE);
+        return (const void*) altrep_matrix_dataptr(x, FALSE);
     }
 
     double altrep_matrix_real_elt(SEXP x, R_xlen_t i) {
-        double* ptr = (double*) altrep_matrix_dataptr(x, TRUE);
+        double* ptr = (double*) altrep_matrix_dataptr(x, FALSE);
         return ptr[i];
     }
 
+    static SEXP altrep_matrix_summary(SEXP x, Rboolean narm, summary what) {
+        SEXP info = R_altrep_data1(x);
+        return stats_summary(altrep_stats(x, 4), INTEGER(VECTOR_ELT(info, 1))[0], INTEGER(VECTOR_ELT(info, 2))[0], narm, what);
+    }
+
+    SEXP altrep_matrix_sum(SEXP x, Rboolean narm) {
+        return altrep_matrix_summary(x, narm, SUM);
+    }
+
+    SEXP altrep_matrix_min(SEXP x, Rboolean narm) {
+        return altrep_matrix_summary(x, narm, MIN);
+    }
+
+    SEXP altrep_matrix_max(SEXP x, Rboolean narm) {
+        return altrep_matrix_summary(x, narm, MAX);
+    }
+
+    int altrep_matrix_no_na(SEXP x) {
+        return stats_no_na(altrep_stats(x, 4), INTEGER(VECTOR_ELT(R_altrep_data1(x), 2))[0]);
+    }
+
 
 
 
@@ -67,10 +203,15 @@ extern "C" {
 
 
 
-    SEXP make_altrep_vector(double* ptr, size_t len) {
-        SEXP info = PROTECT(Rf_allocVector(VECSXP, 2));
+    SEXP make_altrep_vector(double* ptr, size_t len, bool writable, const ColumnStats* stats, SegmentHeader* header,
+                            const PageSource* source) {
+        SEXP info = PROTECT(Rf_allocVector(VECSXP, 6));
         SET_VECTOR_ELT(info, 0, R_MakeExternalPtr(ptr, R_NilValue, R_NilValue));
         SET_VECTOR_ELT(info, 1, Rf_ScalarInteger(len));
+        SET_VECTOR_ELT(info, 2, Rf_ScalarLogical(writable));
+        SET_VECTOR_ELT(info, 3, stats_pointer(stats));
+        SET_VECTOR_ELT(info, 4, R_MakeExternalPtr(header, R_NilValue, R_NilValue));
+        SET_VECTOR_ELT(info, 5, source_pointer(source));
 
         SEXP alt_vec = PROTECT(R_new_altrep(altrep_vector_class, info, R_NilValue));
 
@@ -98,33 +239,139 @@ extern "C" {
     }
 
     void* altrep_vector_dataptr(SEXP x, Rboolean writeable) {
-        SEXP info = R_altrep_data1(x);
-        double* ptr = (double*) R_ExternalPtrAddr(VECTOR_ELT(info, 0));
-        return (void*) ptr;
+        return altrep_real_dataptr(x, 2, 5, altrep_vector_length(x), writeable);
     }
 
     const void* altrep_vector_dataptr_or_null(SEXP x) {
-        return (const void*) altrep_vector_dataptr(x, TRUE);
+        return (const void*) altrep_vector_dataptr(x, FALSE);
     }
 
     double altrep_vector_real_elt(SEXP x, R_xlen_t i) {
-        double* ptr = (double*) altrep_vector_dataptr(x, TRUE);
+        double* ptr = (double*) altrep_vector_dataptr(x, FALSE);
         return ptr[i];
     }
 
+    SEXP altrep_vector_sum(SEXP x, Rboolean narm) {
+        return stats_summary(altrep_stats(x, 3), altrep_vector_length(x), 1, narm, SUM);
+    }
+
+    SEXP altrep_vector_min(SEXP x, Rboolean narm) {
+        return stats_summary(altrep_stats(x, 3), altrep_vector_length(x), 1, narm, MIN);
+    }
+
+    SEXP altrep_vector_max(SEXP x, Rboolean narm) {
+        return stats_summary(altrep_stats(x, 3), altrep_vector_length(x), 1, narm, MAX);
+    }
+
+    int altrep_vector_no_na(SEXP x) {
+        return stats_no_na(altrep_stats(x, 3), 1);
+    }
+
+
+
+
+
+
+
+    SEXP make_altrep_tile(double* ptr, size_t nrow, size_t ncol, size_t ld, SEXP handle) {
+        SEXP info = PROTECT(Rf_allocVector(VECSXP, 5));
+        SET_VECTOR_ELT(info, 0, R_MakeExternalPtr(ptr, R_NilValue, R_NilValue)); // first element of the tile
+        SET_VECTOR_ELT(info, 1, Rf_ScalarInteger(nrow));
+        SET_VECTOR_ELT(info, 2, Rf_ScalarInteger(ncol));
+        SET_VECTOR_ELT(info, 3, Rf_ScalarReal(static_cast<double>(ld))); // leading dimension, may exceed an int
+        SET_VECTOR_ELT(info, 4, handle); // keeps the page mapped
+
+        SEXP alt_tile = PROTECT(R_new_altrep(altrep_tile_class, info, R_NilValue));
+
+        SEXP dim = PROTECT(Rf_allocVector(INTSXP, 2));
+        INTEGER(dim)[0] = nrow;
+        INTEGER(dim)[1] = ncol;
+        Rf_setAttrib(alt_tile, R_DimSymbol, dim);
+
+        UNPROTECT(3);
+        return alt_tile;
+    }
+
+    Rboolean altrep_tile_inspect(SEXP x, int min, int max, int showData, void (*callBack)(SEXP, int, int, int)) {
+        Rprintf("Inspecting external double tile ALTREP\n");
+        if (showData) {
+            for (int i = min; i < max; i++) {
+                callBack(x, i, i+1, 1);
+            }
+        }
+        return TRUE;
+    }
+
+    R_xlen_t altrep_tile_length(SEXP x) {
+        SEXP info = R_altrep_data1(x);
+        return static_cast<R_xlen_t>(INTEGER(VECTOR_ELT(info, 1))[0]) * INTEGER(VECTOR_ELT(info, 2))[0];
+    }
+
+    R_xlen_t altrep_tile_get_region(SEXP x, R_xlen_t i, R_xlen_t n, double* buf) {
+        SEXP copy = R_altrep_data2(x);
+        R_xlen_t len = altrep_tile_length(x);
+        if (i >= len) return 0;
+        if (n > len - i) n = len - i;
+        if (copy != R_NilValue) {
+            std::memcpy(buf, REAL(copy) + i, static_cast<size_t>(n) * sizeof(double));
+            return n;
+        }
+        SEXP info = R_altrep_data1(x);
+        const double* ptr = (const double*) R_ExternalPtrAddr(VECTOR_ELT(info, 0));
+        R_xlen_t nrow = INTEGER(VECTOR_ELT(info, 1))[0];
+        R_xlen_t ld = static_cast<R_xlen_t>(REAL(VECTOR_ELT(info, 3))[0]);
+        // copy column pieces; each is contiguous in the matrix
+        R_xlen_t done = 0;
+        while (done < n) {
+            R_xlen_t row = (i + done) % nrow, col = (i + done) / nrow;
+            R_xlen_t piece = std::min(nrow - row, n - done);
+            std::memcpy(buf + done, ptr + col * ld + row, static_cast<size_t>(piece) * sizeof(double));
+            done += piece;
+        }
+        return n;
+    }
+
+    void* altrep_tile_dataptr(SEXP x, Rboolean writeable) {
+        (void) writeable;
+        // the elements are not contiguous, hence any pointer request is served by a copy
+        SEXP copy = R_altrep_data2(x);
+        if (copy == R_NilValue) {
+            R_xlen_t len = altrep_tile_length(x);
+            copy = PROTECT(Rf_allocVector(REALSXP, len));
+            altrep_tile_get_region(x, 0, len, REAL(copy));
+            R_set_altrep_data2(x, copy);
+            UNPROTECT(1);
+        }
+        return (void*) REAL(copy);
+    }
+
+    const void* altrep_tile_dataptr_or_null(SEXP x) {
+        // NULL makes R read the tile via Elt and Get_region
+        SEXP copy = R_altrep_data2(x);
+        return copy == R_NilValue ? NULL : (const void*) REAL(copy);
+    }
+
+    double altrep_tile_real_elt(SEXP x, R_xlen_t i) {
+        double v;
+        altrep_tile_get_region(x, i, 1, &v);
+        return v;
+    }
 
 
 
 
 
 
-    SEXP make_altrep_list(metadata* metadatas, double* data) {
-        // list metadata has 2 elements:
-        SEXP info = PROTECT(Rf_allocVector(VECSXP, 2));
+
+    SEXP make_altrep_list(metadata* metadatas, double* data, bool writable, const PageSource* source) {
+        // list metadata has 4 elements:
+        SEXP info = PROTECT(Rf_allocVector(VECSXP, 4));
     
         // Store data_ptrs (cast to void*) and metadata
         SET_VECTOR_ELT(info, 0, R_MakeExternalPtr(data, R_NilValue, R_NilValue)); // data chunk
         SET_VECTOR_ELT(info, 1, R_MakeExternalPtr(metadatas, R_NilValue, R_NilValue)); // the metadata array.
+        SET_VECTOR_ELT(info, 2, Rf_ScalarLogical(writable)); // copy-on-write view, passed on to the elements
+        SET_VECTOR_ELT(info, 3, source_pointer(source)); // where the data chunk lies, passed on to the elements
 
         // Create the ALTREP list object
         SEXP alt_list = PROTECT(R_new_altrep(altrep_list_class, info, R_NilValue));
@@ -156,10 +403,20 @@ extern "C" {
 
         // retrieve the i-th metadata and initialize a new object of this kind and metadata at the position of the current element in the data chunk.
         metadata::type data_type = m[i+1].data_type;
+        bool writable = LOGICAL(VECTOR_ELT(R_altrep_data1(x), 2))[0];
+        // the element lies behind the data chunk in the same section
+        SEXP chunkSource = VECTOR_ELT(R_altrep_data1(x), 3);
+        PageSource* chunk = chunkSource == R_NilValue ? nullptr : (PageSource*) R_ExternalPtrAddr(chunkSource);
+        PageSource element;
+        if (chunk != nullptr) {
+            element = *chunk;
+            element.offset += static_cast<size_t>(reinterpret_cast<char*>(start + sizes[i]) - static_cast<char*>(data));
+        }
+        const PageSource* source = chunk != nullptr ? &element : nullptr;
         if (data_type == metadata::type::MATRIX) {
-            return make_altrep_matrix(start + sizes[i], m[i+1].matrix_data.nrow, m[i+1].matrix_data.ncol);
+            return make_altrep_matrix(start + sizes[i], m[i+1].matrix_data.nrow, m[i+1].matrix_data.ncol, writable, nullptr, nullptr, source);
         } else if (data_type == metadata::type::VECTOR) {
-            return make_altrep_vector(start + sizes[i], m[i+1].vector_data.n);
+            return make_altrep_vector(start + sizes[i], m[i+1].vector_data.n, writable, nullptr, nullptr, source);
         } else if (data_type == metadata::type::LIST) {
             stop("Nested Lists are not supported yet!");
         } else {
@@ -33,12 +33,17 @@ extern "C" {
 #endif
 
 
+#include "column_stats.h"
 #include "metadata.h"
+#include "segment_header.h"
+
+struct PageSource;
 
 // Declaration of the ALTREP classes for each of the allowed types.
 extern R_altrep_class_t altrep_matrix_class;
 extern R_altrep_class_t altrep_vector_class;
 extern R_altrep_class_t altrep_list_class;
+extern R_altrep_class_t altrep_tile_class;
 
 
 extern "C" {
@@ -52,28 +57,55 @@ extern "C" {
      * @param ptr     Pointer to the actual data section.
      * @param nrow    Number of rows of the matrix.
      * @param ncol    Number of cols of the matrix.
+     * @param writable  Whether the memory may be written (a copy-on-write view). Otherwise a request for writable data
+     *                  maps the data privately once (see source), which then replaces the view for this ALTREP.
+     * @param stats     The statistics of the ncol columns (see column_stats.h) or nullptr; sum, min, max and the NA
+     *                  check are answered from them as long as the stats_valid flag of header is set.
+     * @param header    The header of the metadata page holding stats.
+     * @param source    Where ptr lies in its section, for the private mapping; without it (arena variables) or if the
+     *                  section is gone by then, the data is duplicated into R memory instead.
      * 
      * @return ALTREP that looks and behaves exactly like a matrix to R but actually uses the C memory from the shared page.
      */
-    SEXP make_altrep_matrix(double* ptr, size_t nrow, size_t ncol);
+    SEXP make_altrep_matrix(double* ptr, size_t nrow, size_t ncol, bool writable = false, const ColumnStats* stats = nullptr,
+                            SegmentHeader* header = nullptr, const PageSource* source = nullptr);
     /**
      * Get ALTREP wrapper of vector data.
      * 
      * @param ptr     Pointer to the actual data section.
      * @param len     Number of elements of the vector.
+     * @param writable  See make_altrep_matrix.
+     * @param stats, header   See make_altrep_matrix; the vector is one column.
+     * @param source    See make_altrep_matrix.
      * 
      * @return ALTREP that looks and behaves exactly like a vector to R but actually uses the C memory from the shared page.
      */
-    SEXP make_altrep_vector(double* ptr, size_t len);
+    SEXP make_altrep_vector(double* ptr, size_t len, bool writable = false, const ColumnStats* stats = nullptr,
+                            SegmentHeader* header = nullptr, const PageSource* source = nullptr);
     /**
      * Get ALTREP wrapper of a list.
      * 
      * @param metadatas       A contiguous list of metadatas (first is the list metadata and the (i+1)-st is the metadata of element i).
      * @param data            The contiguous data block of this list (memory of all elements in one contiguous block)
+     * @param writable        Whether the elements may be written, see make_altrep_matrix.
+     * @param source          Where data lies in its section, passed on to the elements (see make_altrep_matrix).
      * 
      * @return ALTREP that looks and behaves exactly like a list to R but actually uses the C memory from the shared page.
      */
-    SEXP make_altrep_list(metadata* metadatas, double* data);
+    SEXP make_altrep_list(metadata* metadatas, double* data, bool writable = false, const PageSource* source = nullptr);
+    /**
+     * Get ALTREP wrapper of a tile (a block of rows and columns) of a column-major matrix without copying it.
+     * 
+     * @param ptr     Pointer to the first element of the tile.
+     * @param nrow    Number of rows of the tile.
+     * @param ncol    Number of cols of the tile.
+     * @param ld      Leading dimension, i.e. the number of rows of the matrix the tile lies in.
+     * @param handle  An object kept alive with the tile, which keeps the page mapped (see retrieveTile).
+     * 
+     * @return ALTREP matrix reading the elements of the tile from the shared page. As the tile is not contiguous, a
+     *         request for its data pointer copies it into R memory once (the copy replaces the view from then on).
+     */
+    SEXP make_altrep_tile(double* ptr, size_t nrow, size_t ncol, size_t ld, SEXP handle = R_NilValue);
 
 
     /**
@@ -102,7 +134,7 @@ extern "C" {
      * Returns the data pointer to the raw memory of an ALTREP matrix object.
      * 
      * @param x           The ALTREP matrix object
-     * @param writeable   Whether the memory is const or not.
+     * @param writeable   Whether the memory is const or not; a read-only view is mapped privately then (see make_altrep_matrix).
      * 
      * @result  The raw memory section as a void*.
      */
@@ -124,6 +156,22 @@ extern "C" {
      * @result  The i-th element of the matrix as a double.
      */
     double altrep_matrix_real_elt(SEXP x, R_xlen_t i);
+    /**
+     * Summaries of an ALTREP matrix answered from the column statistics of its page; sum, min and max return NULL
+     * (i.e. R computes them itself) if there are none or if they cannot tell the result (NAs without na.rm).
+     * 
+     * @param x           The ALTREP matrix object
+     * @param narm        Whether NAs are removed.
+     * 
+     * @result  The summary as a scalar double, or NULL.
+     */
+    SEXP altrep_matrix_sum(SEXP x, Rboolean narm);
+    SEXP altrep_matrix_min(SEXP x, Rboolean narm);
+    SEXP altrep_matrix_max(SEXP x, Rboolean narm);
+    /**
+     * Whether the ALTREP matrix is known to contain no NA (0 if unknown).
+     */
+    int altrep_matrix_no_na(SEXP x);
 
     // cf. altrep_matrix functions
     Rboolean altrep_vector_inspect(SEXP x, int min, int max, int showData, void (*callBack)(SEXP, int, int, int));
@@ -131,6 +179,19 @@ extern "C" {
     void* altrep_vector_dataptr(SEXP x, Rboolean writeable);
     const void* altrep_vector_dataptr_or_null(SEXP x);
     double altrep_vector_real_elt(SEXP x, R_xlen_t i);
+    SEXP altrep_vector_sum(SEXP x, Rboolean narm);
+    SEXP altrep_vector_min(SEXP x, Rboolean narm);
+    SEXP altrep_vector_max(SEXP x, Rboolean narm);
+    int altrep_vector_no_na(SEXP x);
+
+
+    // cf. altrep_matrix functions; get_region copies n elements starting at i into buf
+    Rboolean altrep_tile_inspect(SEXP x, int min, int max, int showData, void (*callBack)(SEXP, int, int, int));
+    R_xlen_t altrep_tile_length(SEXP x);
+    void* altrep_tile_dataptr(SEXP x, Rboolean writeable);
+    const void* altrep_tile_dataptr_or_null(SEXP x);
+    double altrep_tile_real_elt(SEXP x, R_xlen_t i);
+    R_xlen_t altrep_tile_get_region(SEXP x, R_xlen_t i, R_xlen_t n, double* buf);
 
 
     /**
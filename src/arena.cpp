@@ -0,0 +1,389 @@
+#include "arena.h"
+#include "memory_page.h"
+#include "reclaim.h"
+
+#include <cstring>
+#include <map>
+#include <memory>
+#include <stdexcept>
+
+namespace {
+
+const std::size_t ARENA_DIRECTORY_BYTES = ARENA_HEADER_BYTES + ARENA_CAPACITY * sizeof(ArenaEntry);
+
+// an arena created by this process with its allocator
+struct OwnedArena {
+    std::unique_ptr<MemoryPage> page;
+    std::uint64_t maxVariableBytes = 0;
+    std::uint64_t top = 0;                          // the bump pointer: everything beyond is free
+    std::map<std::uint64_t, std::uint64_t> free;    // free blocks below top by offset
+    std::vector<std::uint32_t> zombies;             // entries released while still viewed
+};
+
+// an arena mapped by this process for its views: the variables attached and their entries
+struct MappedArena {
+    std::unique_ptr<MemoryPage> page;
+    std::map<std::string, std::uint32_t> views;
+};
+
+std::map<std::string, OwnedArena> owned;
+std::map<std::string, MappedArena> mapped;
+
+ArenaHeader* header_of(MemoryPage* page) {
+    return static_cast<ArenaHeader*>(static_cast<void*>(page->data()));
+}
+
+ArenaEntry* entries_of(MemoryPage* page) {
+    return static_cast<ArenaEntry*>(static_cast<void*>(static_cast<char*>(static_cast<void*>(page->data())) + ARENA_HEADER_BYTES));
+}
+
+char* base_of(MemoryPage* page) {
+    return static_cast<char*>(static_cast<void*>(page->data()));
+}
+
+// FNV-1a
+std::uint64_t hash_name(const std::string& name) {
+    std::uint64_t h = 1469598103934665603ULL;
+    for (unsigned char ch : name) {
+        h ^= ch;
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+bool same_name(const ArenaEntry& e, const std::string& name) {
+    return std::strncmp(e.name, name.c_str(), ARENA_NAME_BYTES) == 0;
+}
+
+// a block of at least bytes bytes: first fit among the free blocks, else from the bump pointer; 0 if there is no room
+std::uint64_t allocate(OwnedArena& a, std::uint64_t bytes) {
+    for (auto it = a.free.begin(); it != a.free.end(); ++it) {
+        if (it->second < bytes) continue;
+        std::uint64_t offset = it->first, size = it->second;
+        a.free.erase(it);
+        if (size > bytes) a.free[offset + bytes] = size - bytes;
+        return offset;
+    }
+    if (a.top + bytes > header_of(a.page.get())->bytes) return 0;
+    std::uint64_t offset = a.top;
+    a.top += bytes;
+    return offset;
+}
+
+// return a block, merging it with its free neighbours and the bump pointer
+void deallocate(OwnedArena& a, std::uint64_t offset, std::uint64_t bytes) {
+    auto next = a.free.find(offset + bytes);
+    if (next != a.free.end()) {
+        bytes += next->second;
+        a.free.erase(next);
+    }
+    auto prev = a.free.lower_bound(offset);
+    if (prev != a.free.begin()) {
+        --prev;
+        if (prev->first + prev->second == offset) {
+            offset = prev->first;
+            bytes += prev->second;
+            a.free.erase(prev);
+        }
+    }
+    if (offset + bytes == a.top) {
+        a.top = offset;
+    } else {
+        a.free[offset] = bytes;
+    }
+}
+
+// free the blocks of released entries whose last view is gone
+void sweep(OwnedArena& a) {
+    ArenaHeader* h = header_of(a.page.get());
+    ArenaEntry* entries = entries_of(a.page.get());
+    for (size_t i = 0; i < a.zombies.size(); ) {
+        ArenaEntry& e = entries[a.zombies[i]];
+        if (e.refcount.load() == 0) {
+            deallocate(a, e.offset, e.bytes);
+            h->used.fetch_sub(e.bytes);
+            e.state.store(ArenaEntry::DELETED);
+            a.zombies[i] = a.zombies.back();
+            a.zombies.pop_back();
+        } else {
+            i++;
+        }
+    }
+}
+
+/**
+ * The arena of a namespace mapped for views or nullptr if the namespace has none. The mapping is kept until the last
+ * view of it is released or the arena is retired by its owner; then it is reopened unless this process still views
+ * variables of it.
+ */
+MappedArena* mapped_arena(const std::string& name_space) {
+    auto it = mapped.find(name_space);
+    if (it != mapped.end()) {
+        if (!header_of(it->second.page.get())->retired.load() || !it->second.views.empty()) return &it->second;
+        mapped.erase(it);
+    }
+
+    // map the header first to learn the size of the section
+    std::unique_ptr<MemoryPage> page;
+    try {
+        page = std::make_unique<MemoryPage>();
+        page->view(name_space + ".arena.", ARENA_HEADER_BYTES, true);
+        const ArenaHeader* h = header_of(page.get());
+        if (h->magic.load() != ARENA_MAGIC || h->retired.load()) return nullptr;
+        std::uint64_t bytes = h->bytes;
+        page = std::make_unique<MemoryPage>();
+        page->view(name_space + ".arena.", bytes, true);
+    } catch (std::runtime_error&) {
+        return nullptr;
+    }
+    MappedArena& m = mapped[name_space];
+    m.page = std::move(page);
+    return &m;
+}
+
+}
+
+std::uint64_t arena_section_bytes(std::uint64_t bytes) {
+    return (ARENA_DIRECTORY_BYTES + ARENA_ALIGN - 1) / ARENA_ALIGN * ARENA_ALIGN + (bytes + ARENA_ALIGN - 1) / ARENA_ALIGN * ARENA_ALIGN;
+}
+
+void arena_create(const std::string& name_space, std::uint64_t bytes, std::uint64_t maxVariableBytes) {
+    if (owned.find(name_space) != owned.end()) {
+        throw std::runtime_error("The namespace " + name_space + " already has an arena!");
+    }
+    OwnedArena a;
+    a.maxVariableBytes = maxVariableBytes;
+    a.top = (ARENA_DIRECTORY_BYTES + ARENA_ALIGN - 1) / ARENA_ALIGN * ARENA_ALIGN;
+    std::uint64_t total = arena_section_bytes(bytes);
+    a.page = std::make_unique<MemoryPage>();
+    try {
+        a.page->alloc(name_space + ".arena.", total, true);
+    } catch (std::runtime_error& e) {
+        throw std::runtime_error("Could not create the arena of namespace " + name_space + ": " + e.what());
+    }
+
+    // the fresh section is zero-filled, i.e. all entries are EMPTY
+    ArenaHeader* h = header_of(a.page.get());
+    h->version = 1;
+    h->capacity = ARENA_CAPACITY;
+    h->bytes = total;
+    h->data_offset = a.top;
+    h->owner_pid = current_pid();
+    h->owner_start = process_start_time(h->owner_pid);
+    h->magic.store(ARENA_MAGIC);
+    owned[name_space] = std::move(a);
+}
+
+void arena_destroy(const std::string& name_space) {
+    auto it = owned.find(name_space);
+    if (it == owned.end()) {
+        throw std::runtime_error("The namespace " + name_space + " has no arena of this session!");
+    }
+    ArenaHeader* h = header_of(it->second.page.get());
+    if (h->count.load() > 0) {
+        throw std::runtime_error("The arena of namespace " + name_space + " still holds " + std::to_string(h->count.load()) +
+                                 " variables, release them first!");
+    }
+    h->retired.store(1);
+    owned.erase(it);
+}
+
+std::uint64_t arena_max_variable(const std::string& name_space) {
+    auto it = owned.find(name_space);
+    return it == owned.end() ? 0 : it->second.maxVariableBytes;
+}
+
+std::uint64_t arena_register(const std::string& name_space, const std::string& varname, bool isMatrix,
+                             std::size_t nrow, std::size_t ncol, const double* src) {
+    if (varname.size() >= ARENA_NAME_BYTES) {
+        throw std::runtime_error("Variable name " + varname + " is too long (at most " + std::to_string(ARENA_NAME_BYTES - 1) + " characters)!");
+    }
+    auto it = owned.find(name_space);
+    if (it == owned.end()) return 0;
+    OwnedArena& a = it->second;
+    sweep(a);
+    ArenaHeader* h = header_of(a.page.get());
+    ArenaEntry* entries = entries_of(a.page.get());
+
+    // the slot: the first free one of the probe sequence, which is searched to its end for the name
+    std::uint64_t start = hash_name(varname) % h->capacity;
+    ArenaEntry* slot = nullptr;
+    for (std::uint32_t i = 0; i < h->capacity; i++) {
+        ArenaEntry& e = entries[(start + i) % h->capacity];
+        std::uint32_t state = e.state.load();
+        if (state == ArenaEntry::USED && same_name(e, varname)) {
+            throw std::runtime_error("Variable was already registered!");
+        }
+        if ((state == ArenaEntry::EMPTY || state == ArenaEntry::DELETED) && slot == nullptr) slot = &e;
+        if (state == ArenaEntry::EMPTY) break;
+    }
+    if (slot == nullptr) return 0;
+
+    std::uint64_t dataBytes = static_cast<std::uint64_t>(nrow) * ncol * sizeof(double);
+    std::uint64_t bytes = (dataBytes + ARENA_ALIGN - 1) / ARENA_ALIGN * ARENA_ALIGN;
+    if (bytes == 0) bytes = ARENA_ALIGN;
+    std::uint64_t offset = allocate(a, bytes);
+    if (offset == 0) return 0;
+
+    // no view can attach to the entry before it is USED
+    slot->state.store(ArenaEntry::BUSY);
+    std::memcpy(base_of(a.page.get()) + offset, src, dataBytes);
+    std::memset(slot->name, 0, ARENA_NAME_BYTES);
+    std::memcpy(slot->name, varname.c_str(), varname.size());
+    slot->is_matrix = isMatrix ? 1 : 0;
+    slot->refcount.store(0);
+    slot->offset = offset;
+    slot->bytes = bytes;
+    slot->nrow = nrow;
+    slot->ncol = ncol;
+    slot->state.store(ArenaEntry::USED);
+    h->used.fetch_add(bytes);
+    h->count.fetch_add(1);
+    return bytes;
+}
+
+bool arena_release(const std::string& name_space, const std::string& varname) {
+    auto it = owned.find(name_space);
+    if (it == owned.end()) return false;
+    OwnedArena& a = it->second;
+    ArenaHeader* h = header_of(a.page.get());
+    ArenaEntry* entries = entries_of(a.page.get());
+
+    std::uint64_t start = hash_name(varname) % h->capacity;
+    for (std::uint32_t i = 0; i < h->capacity; i++) {
+        std::uint32_t index = static_cast<std::uint32_t>((start + i) % h->capacity);
+        ArenaEntry& e = entries[index];
+        std::uint32_t state = e.state.load();
+        if (state == ArenaEntry::EMPTY) return false;
+        if (state != ArenaEntry::USED || !same_name(e, varname)) continue;
+
+        // mark it released before looking at the views: a view attaching meanwhile either is counted or sees it released
+        e.state.store(ArenaEntry::RELEASED);
+        h->count.fetch_sub(1);
+        a.zombies.push_back(index);
+        sweep(a);
+        return true;
+    }
+    return false;
+}
+
+std::vector<std::string> arena_variables() {
+    std::vector<std::string> result;
+    for (auto const& a : owned) {
+        ArenaHeader* h = header_of(a.second.page.get());
+        ArenaEntry* entries = entries_of(a.second.page.get());
+        for (std::uint32_t i = 0; i < h->capacity; i++) {
+            if (entries[i].state.load() == ArenaEntry::USED) {
+                result.push_back(a.first + "." + std::string(entries[i].name, strnlen(entries[i].name, ARENA_NAME_BYTES)));
+            }
+        }
+    }
+    return result;
+}
+
+bool arena_present(const std::string& name_space) {
+    return mapped_arena(name_space) != nullptr;
+}
+
+const double* arena_view(const std::string& name_space, const std::string& varname, bool& isMatrix,
+                         std::size_t& nrow, std::size_t& ncol, bool& attached) {
+    attached = false;
+    MappedArena* m = mapped_arena(name_space);
+    if (m == nullptr) return nullptr;
+    ArenaHeader* h = header_of(m->page.get());
+    ArenaEntry* entries = entries_of(m->page.get());
+
+    auto known = m->views.find(varname);
+    if (known == m->views.end()) {
+        std::uint64_t start = hash_name(varname) % h->capacity;
+        for (std::uint32_t i = 0; i < h->capacity; i++) {
+            std::uint32_t index = static_cast<std::uint32_t>((start + i) % h->capacity);
+            ArenaEntry& e = entries[index];
+            std::uint32_t state = e.state.load();
+            if (state == ArenaEntry::EMPTY) break;
+            if (state != ArenaEntry::USED || !same_name(e, varname)) continue;
+
+            // attach first, then check that the entry still holds the variable (see arena_release)
+            e.refcount.fetch_add(1);
+            if (e.state.load() != ArenaEntry::USED || !same_name(e, varname)) {
+                e.refcount.fetch_sub(1);
+                continue;
+            }
+            known = m->views.insert({varname, index}).first;
+            attached = true;
+            break;
+        }
+        if (known == m->views.end()) return nullptr;
+    }
+
+    const ArenaEntry& e = entries[known->second];
+    isMatrix = e.is_matrix != 0;
+    nrow = static_cast<std::size_t>(e.nrow);
+    ncol = static_cast<std::size_t>(e.ncol);
+    return static_cast<const double*>(static_cast<const void*>(base_of(m->page.get()) + e.offset));
+}
+
+bool arena_release_view(const std::string& name_space, const std::string& varname) {
+    auto it = mapped.find(name_space);
+    if (it == mapped.end()) return false;
+    auto view = it->second.views.find(varname);
+    if (view == it->second.views.end()) return false;
+    entries_of(it->second.page.get())[view->second].refcount.fetch_sub(1);
+    it->second.views.erase(view);
+    if (it->second.views.empty()) mapped.erase(it);
+    return true;
+}
+
+std::vector<std::string> arena_views() {
+    std::vector<std::string> result;
+    for (auto const& m : mapped) {
+        for (auto const& v : m.second.views) result.push_back(m.first + "." + v.first);
+    }
+    return result;
+}
+
+bool arena_usage(const std::string& name_space, std::uint64_t& bytes, std::uint64_t& used, std::uint64_t& count,
+                 std::uint64_t& maxVariableBytes) {
+    auto it = owned.find(name_space);
+    if (it == owned.end()) return false;
+    ArenaHeader* h = header_of(it->second.page.get());
+    bytes = h->bytes - h->data_offset;
+    used = h->used.load();
+    count = h->count.load();
+    maxVariableBytes = it->second.maxVariableBytes;
+    return true;
+}
+
+std::uint64_t arena_charge(const std::string& name_space, std::uint64_t& blocks) {
+    blocks = 0;
+    if (name_space.empty()) {
+        std::uint64_t bytes = 0;
+        for (auto const& o : owned) {
+            const ArenaHeader* h = header_of(o.second.page.get());
+            bytes += h->bytes;
+            blocks += h->used.load();
+        }
+        return bytes;
+    }
+    auto it = owned.find(name_space);
+    if (it != owned.end()) {
+        blocks = header_of(it->second.page.get())->used.load();
+        return header_of(it->second.page.get())->bytes;
+    }
+    auto m = mapped.find(name_space);
+    if (m != mapped.end() && !header_of(m->second.page.get())->retired.load()) {
+        blocks = header_of(m->second.page.get())->used.load();
+        return header_of(m->second.page.get())->bytes;
+    }
+    // the arena of another session not mapped for views: only its header is mapped, and only for this lookup
+    MemoryPage page;
+    try {
+        page.view(name_space + ".arena.", ARENA_HEADER_BYTES, true);
+    } catch (std::runtime_error&) {
+        return 0;
+    }
+    const ArenaHeader* h = header_of(&page);
+    if (h->magic.load() != ARENA_MAGIC || h->retired.load()) return 0;
+    blocks = h->used.load();
+    return h->bytes;
+}
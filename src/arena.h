@@ -0,0 +1,152 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef> // size_t
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * An arena packs many small variables of a namespace into one shared memory section (named namespace + ".arena.")
+ * instead of a data and a metadata page per variable. The section starts with a header and a directory of the
+ * variables (an open-addressing table like the catalog, see catalog.h) followed by the data; a viewer maps the whole
+ * section once and attaches to any number of its variables without further system calls.
+ *
+ * Only the process that created the arena allocates in it: its allocator (first fit over a free list, a bump pointer
+ * beyond) lives in that process. Viewers count themselves in the directory entry of a variable; a released variable
+ * keeps its block until its last view is gone, so that the block is never reused under a view.
+ *
+ * Arenas hold double matrices and vectors. This file does not depend on R; errors are reported as std::runtime_error.
+ * The functions are meant to be called from the main thread.
+ */
+
+const std::uint64_t ARENA_MAGIC = 0x4d454d4152454e41ULL; // "MEMARENA"
+const std::uint32_t ARENA_CAPACITY = 4096;
+const std::size_t ARENA_NAME_BYTES = 88;
+const std::size_t ARENA_ALIGN = 64;
+
+struct ArenaEntry {
+    enum state : std::uint32_t {
+        EMPTY = 0,     // never used; ends a probe sequence
+        BUSY = 1,      // claimed by the owner, the fields are being written
+        USED = 2,
+        RELEASED = 3,  // released by the owner, its block is kept until the last view is gone
+        DELETED = 4    // tombstone, can be claimed again
+    };
+    std::atomic<std::uint32_t> state;
+    std::uint32_t is_matrix;
+    std::atomic<std::int64_t> refcount; // number of views currently attached
+    std::uint64_t offset;               // of the data from the start of the section
+    std::uint64_t bytes;                // size of the block
+    std::uint64_t nrow, ncol;           // dimensions; a vector of length n has n rows and one column
+    char name[ARENA_NAME_BYTES];        // variable name (without the namespace), zero-terminated
+};
+
+struct ArenaHeader {
+    std::atomic<std::uint64_t> magic;       // written last by the creator
+    std::uint32_t version;
+    std::uint32_t capacity;
+    std::atomic<std::uint32_t> retired;     // set before the section is removed; holders have to reopen it
+    std::uint32_t reserved;
+    std::uint64_t bytes;                    // size of the section
+    std::uint64_t data_offset;              // start of the data behind the directory
+    std::int64_t owner_pid;                 // the lease of the owner (see reclaim.h)
+    std::uint64_t owner_start;
+    std::atomic<std::uint64_t> used;        // bytes of the blocks allocated
+    std::atomic<std::uint64_t> count;       // number of variables
+};
+
+const std::size_t ARENA_HEADER_BYTES = 128;
+static_assert(sizeof(ArenaHeader) <= ARENA_HEADER_BYTES, "ArenaHeader exceeds its reserved space");
+
+/**
+ * Size of the shared memory section of an arena with a data area of the given size.
+ */
+std::uint64_t arena_section_bytes(std::uint64_t bytes);
+
+/**
+ * Creates the arena of a namespace owned by the calling process. The caller checks the quotas for the size of its
+ * section (see arena_section_bytes).
+ *
+ * @param name_space        The namespace (including the "Local\\" prefix on Windows).
+ * @param bytes             Size of its data area.
+ * @param maxVariableBytes  Variables up to this size are registered in the arena (see arena_max_variable).
+ */
+void arena_create(const std::string& name_space, std::uint64_t bytes, std::uint64_t maxVariableBytes);
+
+/**
+ * Removes the arena of a namespace owned by the calling process; it must not hold variables anymore. Viewers keep
+ * their mapping until they release their views.
+ */
+void arena_destroy(const std::string& name_space);
+
+/**
+ * The size up to which variables of a namespace go into its arena; 0 if the calling process owns no arena for it.
+ */
+std::uint64_t arena_max_variable(const std::string& name_space);
+
+/**
+ * Copies a matrix (or a vector, ncol = 1) into the arena of a namespace owned by the calling process.
+ *
+ * @result  The size of its block or 0 if the arena has no room for it.
+ */
+std::uint64_t arena_register(const std::string& name_space, const std::string& varname, bool isMatrix,
+                             std::size_t nrow, std::size_t ncol, const double* src);
+
+/**
+ * Releases a variable of the arena of a namespace owned by the calling process.
+ *
+ * @result  Whether the variable was in the arena.
+ */
+bool arena_release(const std::string& name_space, const std::string& varname);
+
+/**
+ * The variables of the arenas owned by the calling process as "namespace.variable".
+ */
+std::vector<std::string> arena_variables();
+
+/**
+ * Whether a namespace has an arena (mapping it for arena_view); one lookup for many variables.
+ */
+bool arena_present(const std::string& name_space);
+
+/**
+ * Attaches to a variable of the arena of a namespace (mapping the arena on first use). Attaching twice is the same as
+ * attaching once.
+ *
+ * @param attached    Set to whether this call attached the variable (i.e. it was not attached before).
+ *
+ * @result  Pointer to its data or nullptr if the namespace has no arena or the variable is not in it.
+ */
+const double* arena_view(const std::string& name_space, const std::string& varname, bool& isMatrix,
+                         std::size_t& nrow, std::size_t& ncol, bool& attached);
+
+/**
+ * Detaches from a variable of an arena; the arena is unmapped with the last variable of it.
+ *
+ * @result  Whether the variable was attached.
+ */
+bool arena_release_view(const std::string& name_space, const std::string& varname);
+
+/**
+ * The variables attached via arena_view as "namespace.variable".
+ */
+std::vector<std::string> arena_views();
+
+/**
+ * Size, allocated bytes and number of variables of the arena of a namespace owned by the calling process.
+ *
+ * @result  Whether the calling process owns an arena for the namespace.
+ */
+bool arena_usage(const std::string& name_space, std::uint64_t& bytes, std::uint64_t& used, std::uint64_t& count,
+                 std::uint64_t& maxVariableBytes);
+
+/**
+ * What arenas count against the quotas (see getPageQuota): the size of the section of the arena of a namespace,
+ * read from its header if another process owns it, or for "" the size of all arenas owned by the calling process.
+ *
+ * @param blocks    Set to the size of the blocks of their variables, which the catalog counts as well.
+ *
+ * @result  The size of the sections; 0 if there is no arena.
+ */
+std::uint64_t arena_charge(const std::string& name_space, std::uint64_t& blocks);
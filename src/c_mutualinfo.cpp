@@ -1,7 +1,10 @@
 #include "c_mutualinfo.h"
+#include "mi_estimator.h"
 
+#include <algorithm>
 #include <cmath>
 #include <iostream>
+#include <vector>
 
 using namespace Rcpp;
 
@@ -9,29 +12,29 @@ using namespace Rcpp;
 double mutualinfo(Rcpp::IntegerMatrix joint, int n) {
   int rows = joint.nrow();
   int cols = joint.ncol();
+  double invn = 1.0 / n;
 
-  double* px = new double[rows]();
-  double* py = new double[cols]();
+  std::vector<double> px(rows, 0.0);
+  std::vector<double> py(cols, 0.0);
 
-  for (int i = 0; i < rows; i++) {
-    for (int j = 0; j < cols; j++) {
-      px[i] += joint(i,j) / (double) n;
-      py[j] += joint(i,j) / (double) n;
+  for (int j = 0; j < cols; j++) {
+    for (int i = 0; i < rows; i++) {
+      double pxy = joint(i, j) * invn;
+      px[i] += pxy;
+      py[j] += pxy;
     }
   }
 
   double mi = 0;
 
-  for (int i = 0; i < rows; i++) {
-    for (int j = 0; j < cols; j++) {
+  for (int j = 0; j < cols; j++) {
+    for (int i = 0; i < rows; i++) {
       if (joint(i, j) > 0) {
-        double pxy = joint(i, j) / (double) n;
+        double pxy = joint(i, j) * invn;
         mi += pxy * log(pxy / (px[i] * py[j]));
       }
     }
   }
-  delete[] px;
-  delete[] py;
 
   return mi / log(2);
 }
@@ -49,3 +52,73 @@ extern "C" SEXP C_mutualinfo(SEXP jointSEXP, SEXP nSEXP) {
       Rf_error("mutualinfo unknown error");
     }
 }
+
+// validated number of grid points; codes are stored as uint16 with one reserved value
+static std::size_t as_nbins(SEXP nbinsSEXP) {
+    int nbins = as<int>(nbinsSEXP);
+    if (nbins < 3 || nbins > 65535) {
+        throw std::invalid_argument("nbins has to be between 3 and 65535");
+    }
+    return static_cast<std::size_t>(nbins);
+}
+
+extern "C" SEXP C_mutualinfo_continuous(SEXP xSEXP, SEXP ySEXP, SEXP nbinsSEXP, SEXP lambdaSEXP, SEXP epsSEXP) {
+    try {
+      NumericVector x(xSEXP), y(ySEXP);
+      if (x.size() != y.size()) {
+        throw std::invalid_argument("x and y have to be of the same length");
+      }
+      double res = mutualinfo_continuous(x.begin(), y.begin(), x.size(), as_nbins(nbinsSEXP),
+                                         as<double>(lambdaSEXP), as<double>(epsSEXP), mi_workspace());
+      return wrap(res);
+    } catch (std::exception &e) {
+      Rf_error("mutualinfo error: %s", e.what());
+    } catch (...) {
+      Rf_error("mutualinfo unknown error");
+    }
+}
+
+extern "C" SEXP C_mutualinfo_mixed(SEXP xSEXP, SEXP ySEXP, SEXP nbinsSEXP, SEXP lambdaSEXP, SEXP epsSEXP) {
+    try {
+      NumericVector x(xSEXP), y(ySEXP);
+      if (x.size() != y.size()) {
+        throw std::invalid_argument("x and y have to be of the same length");
+      }
+      // map the levels of y onto 0, ..., ny - 1; non-finite values are left out
+      MIWorkspace& ws = mi_workspace();
+      std::vector<double> levels;
+      ws.ly.resize(y.size());
+      std::size_t ny = level_codes(y.begin(), y.size(), levels, ws.ly.data());
+
+      double res = mutualinfo_mixed(x.begin(), ws.ly.data(), x.size(), ny, as_nbins(nbinsSEXP),
+                                    as<double>(lambdaSEXP), as<double>(epsSEXP), ws);
+      return wrap(res);
+    } catch (std::exception &e) {
+      Rf_error("mutualinfo error: %s", e.what());
+    } catch (...) {
+      Rf_error("mutualinfo unknown error");
+    }
+}
+
+extern "C" SEXP C_mutualinfo_discrete(SEXP xSEXP, SEXP ySEXP) {
+    try {
+      NumericVector x(xSEXP), y(ySEXP);
+      if (x.size() != y.size()) {
+        throw std::invalid_argument("x and y have to be of the same length");
+      }
+      // code the levels of both samples once and count the joint table natively
+      MIWorkspace& ws = mi_workspace();
+      std::vector<double> levels;
+      ws.lx.resize(x.size());
+      ws.ly.resize(y.size());
+      std::size_t kx = level_codes(x.begin(), x.size(), levels, ws.lx.data());
+      std::size_t ky = level_codes(y.begin(), y.size(), levels, ws.ly.data());
+
+      double res = mutualinfo_discrete(ws.lx.data(), kx, ws.ly.data(), ky, x.size(), ws);
+      return wrap(res);
+    } catch (std::exception &e) {
+      Rf_error("mutualinfo error: %s", e.what());
+    } catch (...) {
+      Rf_error("mutualinfo unknown error");
+    }
+}
@@ -3,3 +3,29 @@
 double mutualinfo(Rcpp::IntegerMatrix joint, int n);
 
 extern "C" SEXP C_mutualinfo(SEXP jointSEXP, SEXP nSEXP);
+
+/**
+ * Native mutual information of two continuous variables (see mi_estimator.h).
+ *
+ * @param xSEXP, ySEXP      Numeric vectors of the same length.
+ * @param nbinsSEXP         Number of grid points per variable.
+ * @param lambdaSEXP        Smoothing parameter of the histogram smoothing.
+ * @param epsSEXP           Densities below 2 * eps are disregarded.
+ *
+ * @result  The mutual information or NaN if a Pareto radius could not be determined.
+ */
+extern "C" SEXP C_mutualinfo_continuous(SEXP xSEXP, SEXP ySEXP, SEXP nbinsSEXP, SEXP lambdaSEXP, SEXP epsSEXP);
+
+/**
+ * Native mutual information of a continuous variable x and a discrete variable y (see mi_estimator.h).
+ *
+ * @result  The mutual information or NaN if the Pareto radius of x could not be determined.
+ */
+extern "C" SEXP C_mutualinfo_mixed(SEXP xSEXP, SEXP ySEXP, SEXP nbinsSEXP, SEXP lambdaSEXP, SEXP epsSEXP);
+
+/**
+ * Native mutual information (in bits) of two discrete variables; the joint table is counted without an R table.
+ *
+ * @param xSEXP, ySEXP      Numeric vectors of the same length; non-finite values are left out pairwise.
+ */
+extern "C" SEXP C_mutualinfo_discrete(SEXP xSEXP, SEXP ySEXP);
@@ -0,0 +1,304 @@
+#include "catalog.h"
+#include "memory_page.h"
+#include "reclaim.h"
+
+#include <chrono>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+namespace {
+
+const std::size_t CATALOG_BYTES = CATALOG_HEADER_BYTES + CATALOG_CAPACITY * sizeof(CatalogEntry);
+
+// the catalogs mapped by this process, by namespace
+std::map<std::string, std::unique_ptr<MemoryPage>> catalogs;
+std::mutex catalogMutex;
+
+CatalogHeader* header_of(MemoryPage* page) {
+    return static_cast<CatalogHeader*>(static_cast<void*>(page->data()));
+}
+
+CatalogEntry* entries_of(MemoryPage* page) {
+    return static_cast<CatalogEntry*>(static_cast<void*>(static_cast<char*>(static_cast<void*>(page->data())) + CATALOG_HEADER_BYTES));
+}
+
+// FNV-1a
+std::uint64_t hash_name(const std::string& name) {
+    std::uint64_t h = 1469598103934665603ULL;
+    for (unsigned char ch : name) {
+        h ^= ch;
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+bool same_name(const CatalogEntry& e, const std::string& name) {
+    return std::strncmp(e.name, name.c_str(), CATALOG_NAME_BYTES) == 0;
+}
+
+/**
+ * The count of variables doubles as the cross-process lock of the removal of a catalog: the process taking it from 1
+ * to 0 swaps in RETIRED_COUNT instead, and a registration only adds to a count without this bit. Either the
+ * registration comes first and the catalog stays, or the removal does and the registration reopens a new catalog.
+ */
+bool enter(CatalogHeader* h) {
+    std::uint64_t c = h->count.load();
+    while (!(c & RETIRED_COUNT)) {
+        if (h->count.compare_exchange_weak(c, c + 1)) return true;
+    }
+    return false;
+}
+
+// the counterpart of enter; the catalog has to be removed if this results in true
+bool leave(CatalogHeader* h) {
+    std::uint64_t c = h->count.load();
+    for (;;) {
+        if (h->count.compare_exchange_weak(c, c == 1 ? RETIRED_COUNT : c - 1)) return c == 1;
+    }
+}
+
+bool is_retired(CatalogHeader* h) {
+    return h->retired.load() || (h->count.load() & RETIRED_COUNT);
+}
+
+/**
+ * Leaves the catalog (see leave) and removes it if this was its last variable; processes still holding it will reopen
+ * a new one. The caller holds catalogMutex.
+ *
+ * @result  Whether the catalog was removed.
+ */
+bool leave_catalog(const std::string& name_space, CatalogHeader* h) {
+    if (!leave(h)) return false;
+    h->retired.store(1);
+    MemoryPage::unlink(name_space + ".cat.");
+    catalogs.erase(name_space);
+    return true;
+}
+
+/**
+ * Marks an entry deleted. With the last entry the catalog is removed (see leave_catalog). The caller holds catalogMutex.
+ *
+ * @result  Whether the catalog was removed.
+ */
+bool remove_entry(const std::string& name_space, CatalogHeader* h, CatalogEntry& e) {
+    std::uint32_t state = CatalogEntry::USED;
+    if (!e.state.compare_exchange_strong(state, CatalogEntry::DELETED)) return false;
+    h->total_bytes.fetch_sub(e.bytes);
+    return leave_catalog(name_space, h);
+}
+
+/**
+ * The catalog of a namespace mapped into this process or nullptr if it does not exist (and create is not set).
+ * Catalogs that were retired by another process are reopened. The caller holds catalogMutex.
+ */
+MemoryPage* catalog_page(const std::string& name_space, bool create) {
+    auto it = catalogs.find(name_space);
+    if (it != catalogs.end()) {
+        if (!is_retired(header_of(it->second.get()))) return it->second.get();
+        catalogs.erase(it);
+    }
+
+    for (int attempt = 0; attempt < 100; attempt++) {
+        auto page = std::make_unique<MemoryPage>();
+        bool created;
+        try {
+            created = page->open(name_space + ".cat.", CATALOG_BYTES, create);
+        } catch (std::runtime_error&) {
+            if (!create) return nullptr;
+            throw;
+        }
+
+        CatalogHeader* h = header_of(page.get());
+        if (created) {
+            h->version = 2;
+            h->capacity = CATALOG_CAPACITY;
+            h->magic.store(CATALOG_MAGIC);
+        } else {
+            // wait for the creator to finish the initialization
+            for (int i = 0; h->magic.load() != CATALOG_MAGIC; i++) {
+                if (i > 1000) throw std::runtime_error("The catalog of namespace " + name_space + " is corrupt.");
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        }
+        if (!is_retired(h)) {
+            MemoryPage* result = page.get();
+            catalogs[name_space] = std::move(page);
+            return result;
+        }
+        // we raced with the removal of the catalog, wait until its name is gone
+        if (!create) return nullptr;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    throw std::runtime_error("Could not open the catalog of namespace " + name_space);
+}
+
+}
+
+bool catalog_register(const std::string& name_space, const std::string& varname, std::uint64_t bytes) {
+    if (varname.size() >= CATALOG_NAME_BYTES) return false;
+    std::lock_guard<std::mutex> lock(catalogMutex);
+    MemoryPage* page = nullptr;
+    CatalogHeader* h = nullptr;
+    for (int attempt = 0; ; attempt++) {
+        page = catalog_page(name_space, true);
+        h = header_of(page);
+        if (enter(h)) break;
+        // the catalog is being removed by another process, open the next one once its name is gone
+        if (attempt >= 1000) return false;
+        catalogs.erase(name_space);
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    CatalogEntry* entries = entries_of(page);
+
+    std::uint64_t start = hash_name(varname) % h->capacity;
+    for (std::uint32_t i = 0; i < h->capacity; i++) {
+        CatalogEntry& e = entries[(start + i) % h->capacity];
+        std::uint32_t state = e.state.load();
+        if (state == CatalogEntry::EMPTY) break;
+        if (state == CatalogEntry::USED && same_name(e, varname) && e.state.compare_exchange_strong(state, CatalogEntry::BUSY)) {
+            // a stale entry of a crashed owner, the segments themselves are gone as the registration succeeded
+            h->total_bytes.fetch_sub(e.bytes);
+            e.owner_pid = current_pid();
+            e.owner_start = process_start_time(e.owner_pid);
+            e.bytes = bytes;
+            e.refcount.store(0);
+            h->total_bytes.fetch_add(bytes);
+            e.state.store(CatalogEntry::USED);
+            // the entry was counted already
+            leave_catalog(name_space, h);
+            return true;
+        }
+    }
+    for (std::uint32_t i = 0; i < h->capacity; i++) {
+        CatalogEntry& e = entries[(start + i) % h->capacity];
+        std::uint32_t state = e.state.load();
+        if ((state == CatalogEntry::EMPTY || state == CatalogEntry::DELETED) &&
+            e.state.compare_exchange_strong(state, CatalogEntry::BUSY)) {
+            std::memset(e.name, 0, CATALOG_NAME_BYTES);
+            std::memcpy(e.name, varname.c_str(), varname.size());
+            e.owner_pid = current_pid();
+            e.owner_start = process_start_time(e.owner_pid);
+            e.bytes = bytes;
+            e.refcount.store(0);
+            e.state.store(CatalogEntry::USED);
+            h->total_bytes.fetch_add(bytes);
+            return true;
+        }
+    }
+    // a full catalog only loses track of the variable
+    leave_catalog(name_space, h);
+    return false;
+}
+
+void catalog_unregister(const std::string& name_space, const std::string& varname) {
+    std::lock_guard<std::mutex> lock(catalogMutex);
+    MemoryPage* page = catalog_page(name_space, false);
+    if (page == nullptr) return;
+    CatalogHeader* h = header_of(page);
+    CatalogEntry* entries = entries_of(page);
+
+    std::uint64_t start = hash_name(varname) % h->capacity;
+    for (std::uint32_t i = 0; i < h->capacity; i++) {
+        CatalogEntry& e = entries[(start + i) % h->capacity];
+        std::uint32_t state = e.state.load();
+        if (state == CatalogEntry::EMPTY) break;
+        if (state == CatalogEntry::USED && same_name(e, varname) && remove_entry(name_space, h, e)) return;
+    }
+}
+
+void catalog_resize(const std::string& name_space, const std::string& varname, std::uint64_t bytes) {
+    std::lock_guard<std::mutex> lock(catalogMutex);
+    MemoryPage* page = catalog_page(name_space, false);
+    if (page == nullptr) return;
+    CatalogHeader* h = header_of(page);
+    CatalogEntry* entries = entries_of(page);
+
+    std::uint64_t start = hash_name(varname) % h->capacity;
+    for (std::uint32_t i = 0; i < h->capacity; i++) {
+        CatalogEntry& e = entries[(start + i) % h->capacity];
+        std::uint32_t state = e.state.load();
+        if (state == CatalogEntry::EMPTY) return;
+        if (state == CatalogEntry::USED && same_name(e, varname)) {
+            h->total_bytes.fetch_sub(e.bytes);
+            e.bytes = bytes;
+            h->total_bytes.fetch_add(bytes);
+            return;
+        }
+    }
+}
+
+void catalog_attach(const std::string& name_space, const std::string& varname, int delta) {
+    std::lock_guard<std::mutex> lock(catalogMutex);
+    MemoryPage* page = catalog_page(name_space, false);
+    if (page == nullptr) return;
+    CatalogHeader* h = header_of(page);
+    CatalogEntry* entries = entries_of(page);
+
+    std::uint64_t start = hash_name(varname) % h->capacity;
+    for (std::uint32_t i = 0; i < h->capacity; i++) {
+        CatalogEntry& e = entries[(start + i) % h->capacity];
+        std::uint32_t state = e.state.load();
+        if (state == CatalogEntry::EMPTY) return;
+        if (state == CatalogEntry::USED && same_name(e, varname)) {
+            e.refcount.fetch_add(delta);
+            return;
+        }
+    }
+}
+
+std::vector<CatalogRecord> catalog_list(const std::string& name_space) {
+    std::lock_guard<std::mutex> lock(catalogMutex);
+    std::vector<CatalogRecord> result;
+    MemoryPage* page = catalog_page(name_space, false);
+    if (page == nullptr) return result;
+    CatalogHeader* h = header_of(page);
+    CatalogEntry* entries = entries_of(page);
+
+    for (std::uint32_t i = 0; i < h->capacity; i++) {
+        CatalogEntry& e = entries[i];
+        if (e.state.load() != CatalogEntry::USED) continue;
+        CatalogRecord r;
+        r.name = std::string(e.name, strnlen(e.name, CATALOG_NAME_BYTES));
+        r.owner_pid = e.owner_pid;
+        r.bytes = e.bytes;
+        r.refcount = e.refcount.load();
+        result.push_back(r);
+    }
+    return result;
+}
+
+std::vector<CatalogRecord> catalog_prune(const std::string& name_space, bool dryRun) {
+    std::lock_guard<std::mutex> lock(catalogMutex);
+    std::vector<CatalogRecord> result;
+    MemoryPage* page = catalog_page(name_space, false);
+    if (page == nullptr) return result;
+    CatalogHeader* h = header_of(page);
+    CatalogEntry* entries = entries_of(page);
+
+    for (std::uint32_t i = 0; i < h->capacity; i++) {
+        CatalogEntry& e = entries[i];
+        if (e.state.load() != CatalogEntry::USED || process_alive(e.owner_pid, e.owner_start)) continue;
+        CatalogRecord r;
+        r.name = std::string(e.name, strnlen(e.name, CATALOG_NAME_BYTES));
+        r.owner_pid = e.owner_pid;
+        r.bytes = e.bytes;
+        r.refcount = e.refcount.load();
+        result.push_back(r);
+        if (!dryRun && remove_entry(name_space, h, e)) break;
+    }
+    return result;
+}
+
+std::uint64_t catalog_usage(const std::string& name_space) {
+    std::lock_guard<std::mutex> lock(catalogMutex);
+    MemoryPage* page = catalog_page(name_space, false);
+    return page == nullptr ? 0 : header_of(page)->total_bytes.load();
+}
+
+std::size_t catalog_bytes() {
+    return CATALOG_BYTES;
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef> // size_t
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * Every namespace has a catalog: a shared memory section (named namespace + ".cat.") holding a fixed-capacity
+ * open-addressing table of all variables registered in the namespace by any process, their owner, their size and
+ * the number of views currently attached to them.
+ *
+ * Slots are claimed lock-free via compare-and-swap on their state, hence a crashed process can never block the
+ * catalog. The catalog is created with the first registration of a namespace and removed when its last variable
+ * is released. Variables whose name has CATALOG_NAME_BYTES or more characters and variables beyond the capacity of the
+ * catalog are registered all the same, only without an entry: they are missing from namespaceCatalog and the usage.
+ *
+ * This file does not depend on R; errors are reported as std::runtime_error.
+ */
+
+const std::uint64_t CATALOG_MAGIC = 0x4d454d4341544c47ULL; // "MEMCATLG"
+const std::uint32_t CATALOG_CAPACITY = 1024;
+const std::size_t CATALOG_NAME_BYTES = 88;
+// set in CatalogHeader::count while the catalog is removed (see catalog.cpp)
+const std::uint64_t RETIRED_COUNT = 1ULL << 63;
+
+struct CatalogEntry {
+    enum state : std::uint32_t {
+        EMPTY = 0,     // never used; ends a probe sequence
+        BUSY = 1,      // claimed, the fields are being written
+        USED = 2,
+        DELETED = 3    // tombstone, can be claimed again
+    };
+    std::atomic<std::uint32_t> state;
+    std::uint32_t reserved;
+    std::int64_t owner_pid;
+    std::uint64_t owner_start;          // start time of the owner process (see reclaim.h)
+    std::uint64_t bytes;                // size of the data and metadata pages
+    std::atomic<std::int64_t> refcount; // number of views currently attached
+    char name[CATALOG_NAME_BYTES];      // variable name (without the namespace), zero-terminated
+};
+
+struct CatalogHeader {
+    std::atomic<std::uint64_t> magic;       // written last by the creator
+    std::uint32_t version;
+    std::uint32_t capacity;
+    std::atomic<std::uint32_t> retired;     // set before the section is removed; holders have to reopen it
+    std::atomic<std::uint64_t> count;       // number of variables (and registrations in progress), RETIRED_COUNT when removed
+    std::atomic<std::uint64_t> total_bytes; // their total size
+};
+
+const std::size_t CATALOG_HEADER_BYTES = 64;
+static_assert(sizeof(CatalogHeader) <= CATALOG_HEADER_BYTES, "CatalogHeader exceeds its reserved space");
+
+/**
+ * A copy of a catalog entry.
+ */
+struct CatalogRecord {
+    std::string name;
+    std::int64_t owner_pid;
+    std::uint64_t bytes;
+    std::int64_t refcount;
+};
+
+/**
+ * Adds a variable owned by the calling process to the catalog of its namespace (creating the catalog if needed).
+ *
+ * @param name_space    The namespace (including the "Local\\" prefix on Windows).
+ * @param varname       The variable name.
+ * @param bytes         Size of its data and metadata pages.
+ *
+ * @result  Whether the variable got an entry; false for too long names and a full catalog.
+ */
+bool catalog_register(const std::string& name_space, const std::string& varname, std::uint64_t bytes);
+
+/**
+ * Removes a variable from the catalog; the catalog is removed with its last variable.
+ */
+void catalog_unregister(const std::string& name_space, const std::string& varname);
+
+/**
+ * Update the size of a variable owned by the calling process (e.g. when a new generation is published); no-op if it
+ * is not in the catalog.
+ */
+void catalog_resize(const std::string& name_space, const std::string& varname, std::uint64_t bytes);
+
+/**
+ * Increment (delta = 1) or decrement (delta = -1) the number of views of a variable; no-op if it is not in the catalog.
+ */
+void catalog_attach(const std::string& name_space, const std::string& varname, int delta);
+
+/**
+ * All variables of a namespace in one lookup; empty if the namespace has no catalog.
+ */
+std::vector<CatalogRecord> catalog_list(const std::string& name_space);
+
+/**
+ * Removes the entries of dead owners (see process_alive) from the catalog of a namespace.
+ *
+ * @param dryRun      Only report the entries.
+ *
+ * @result  The removed entries.
+ */
+std::vector<CatalogRecord> catalog_prune(const std::string& name_space, bool dryRun);
+
+/**
+ * Total size of the variables of a namespace registered by all processes; 0 if the namespace has no catalog.
+ */
+std::uint64_t catalog_usage(const std::string& name_space);
+
+/**
+ * Size of the shared memory section of a catalog.
+ */
+std::size_t catalog_bytes();
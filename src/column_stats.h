@@ -0,0 +1,82 @@
+#pragma once
+
+#include <algorithm> // std::max
+#include <cmath>
+#include <cstddef> // size_t
+#include <cstdint>
+#include <limits>
+
+#include "parallel.h"
+
+/**
+ * Summary statistics of a column of a matrix (a vector is a matrix of one column). The owner computes them while it
+ * copies the object into its data page and stores them behind the metadata (see SegmentHeader::stats_offset), so that
+ * every worker reads them instead of scanning the columns itself.
+ *
+ * NA and NaN are counted in na_count and left out of all other fields; a column of NAs only has sum 0 and NaN for
+ * mean, sd, min and max.
+ */
+struct ColumnStats {
+    double sum;
+    double mean;
+    double sd;              // sample standard deviation (n - 1), NaN for fewer than two values
+    double min, max;
+    std::uint64_t na_count;
+    std::uint64_t reserved;
+};
+
+/**
+ * Copies a column-major matrix and computes the statistics of its columns in the same pass; the columns are spread
+ * over up to nthreads threads.
+ *
+ * @note    Does not call into R.
+ *
+ * @param dst, src      The matrices of nrow * ncol doubles.
+ * @param stats         The ncol statistics to write.
+ * @param nthreads      Maximum number of threads (0 = default_threads()).
+ */
+inline void copy_column_stats(double* dst, const double* src, std::size_t nrow, std::size_t ncol, ColumnStats* stats,
+                              std::size_t nthreads) {
+    // columns are handed out in groups of at least a few MB so that short columns do not thrash the threads
+    std::size_t grain = std::max<std::size_t>(1, (std::size_t(4) << 20) / std::max<std::size_t>(1, nrow * sizeof(double)));
+    parallel_for(ncol, nthreads, [&](std::size_t j) {
+        const double* in = src + j * nrow;
+        double* out = dst + j * nrow;
+        // the squares are taken around the first value, which keeps the variance accurate for large means
+        double shift = 0;
+        bool shifted = false;
+        long double sum = 0, shiftedSum = 0, shiftedSquares = 0;
+        double lo = std::numeric_limits<double>::infinity(), hi = -lo;
+        std::uint64_t na = 0;
+        for (std::size_t i = 0; i < nrow; i++) {
+            double v = in[i];
+            out[i] = v;
+            if (std::isnan(v)) {
+                na++;
+                continue;
+            }
+            if (!shifted) {
+                shift = v;
+                shifted = true;
+            }
+            sum += v;
+            long double d = static_cast<long double>(v) - shift;
+            shiftedSum += d;
+            shiftedSquares += d * d;
+            if (v < lo) lo = v;
+            if (v > hi) hi = v;
+        }
+
+        ColumnStats& s = stats[j];
+        std::uint64_t n = nrow - na;
+        double nan = std::numeric_limits<double>::quiet_NaN();
+        s.sum = static_cast<double>(sum);
+        s.mean = n > 0 ? static_cast<double>(sum / n) : nan;
+        long double var = n > 1 ? (shiftedSquares - shiftedSum * shiftedSum / n) / (n - 1) : 0;
+        s.sd = n > 1 ? std::sqrt(static_cast<double>(var < 0 ? 0 : var)) : nan;
+        s.min = n > 0 ? lo : nan;
+        s.max = n > 0 ? hi : nan;
+        s.na_count = na;
+        s.reserved = 0;
+    }, grain);
+}
@@ -0,0 +1,112 @@
+#include "group.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+#include "metadata.h"
+#include "parallel.h"
+#include "shared_memory.h"
+
+namespace {
+
+// rows a thread gathers of a column at once
+const std::size_t GATHER_ROWS = 1 << 16;
+
+}
+
+List groupRows(std::string name_space, std::string matName, IntegerVector groups, int ngroups, std::string indexName,
+               std::string regroupName, int threads) {
+#ifdef _WIN32
+    // For windows we prepend the namespace identifier by "Local\\" because otherwise the shared memory is shared system-wide (instead of user-wide) which needs admin privileges
+    name_space = "Local\\" + name_space;
+#endif
+    if (ngroups < 1) stop("There has to be at least one group!");
+    std::string indexPage = name_space + "." + indexName;
+    std::string regroupPage = name_space + "." + regroupName;
+    if (pages.find(indexPage) != pages.end()) stop("Variable " + indexName + " is already registered!");
+    if (!regroupName.empty() && pages.find(regroupPage) != pages.end()) stop("Variable " + regroupName + " is already registered!");
+
+    // retrieve the matrix; only drop the view afterwards if this call opened it
+    std::string matPage = name_space + "." + matName;
+    bool hadView = hasView(matPage);
+    auto view = viewPage(matPage, name_space + ".md." + matName);
+    if (view->metaPtr()->data_type != metadata::type::MATRIX) {
+        if (!hadView) releaseView(matPage);
+        stop("Variable '" + matName + "' is not a matrix!");
+    }
+    std::size_t nrow = view->metaPtr()->matrix_data.nrow;
+    std::size_t ncol = view->metaPtr()->matrix_data.ncol;
+    const double* X = view->memPtr();
+    if (static_cast<std::size_t>(groups.size()) != nrow) {
+        if (!hadView) releaseView(matPage);
+        stop("There has to be one group for every row of the matrix!");
+    }
+
+    // counting sort: the sizes of the groups give their starts, then every row is put behind its predecessors
+    std::vector<std::size_t> size(ngroups, 0);
+    for (std::size_t i = 0; i < nrow; i++) {
+        int g = groups[i];
+        if (g == NA_INTEGER) continue;
+        if (g < 1 || g > ngroups) {
+            if (!hadView) releaseView(matPage);
+            stop("The groups have to be between 1 and %d!", ngroups);
+        }
+        size[g - 1]++;
+    }
+    std::vector<std::size_t> next(ngroups, 0);
+    for (int g = 1; g < ngroups; g++) next[g] = next[g - 1] + size[g - 1];
+    std::size_t rows = next[ngroups - 1] + size[ngroups - 1];
+    IntegerVector start(ngroups), sizes(ngroups);
+    for (int g = 0; g < ngroups; g++) {
+        start[g] = static_cast<int>(next[g] + 1);
+        sizes[g] = static_cast<int>(size[g]);
+    }
+
+    bool indexRegistered = false, regroupRegistered = false;
+    try {
+        if (rows == 0) stop("Every row of the matrix has a missing group!");
+        double* index = allocMatrixPage(indexPage, name_space + ".md." + indexName, rows, 1);
+        indexRegistered = true;
+        for (std::size_t i = 0; i < nrow; i++) {
+            if (groups[i] != NA_INTEGER) index[next[groups[i] - 1]++] = static_cast<double>(i + 1);
+        }
+
+        if (!regroupName.empty()) {
+            double* out = allocMatrixPage(regroupPage, name_space + ".md." + regroupName, rows, ncol);
+            regroupRegistered = true;
+            // every task gathers a run of rows of one column; the run is written sequentially
+            std::size_t runs = (rows + GATHER_ROWS - 1) / GATHER_ROWS;
+            parallel_for(ncol * runs, threads, [&](std::size_t t) {
+                std::size_t j = t / runs, first = t % runs * GATHER_ROWS;
+                std::size_t last = std::min(rows, first + GATHER_ROWS);
+                const double* in = X + j * nrow;
+                double* o = out + j * rows;
+                for (std::size_t r = first; r < last; r++) o[r] = in[static_cast<std::size_t>(index[r]) - 1];
+            });
+            completeMatrixPage(regroupPage);
+        }
+        completeMatrixPage(indexPage);
+    } catch (...) {
+        if (regroupRegistered) releasePage(regroupPage);
+        if (indexRegistered) releasePage(indexPage);
+        if (!hadView) releaseView(matPage);
+        throw;
+    }
+
+    if (!hadView) releaseView(matPage);
+    return List::create(Named("start") = start, Named("size") = sizes);
+}
+
+extern "C" SEXP C_groupRows(SEXP name_spaceSEXP, SEXP matNameSEXP, SEXP groupsSEXP, SEXP ngroupsSEXP, SEXP indexNameSEXP,
+                            SEXP regroupNameSEXP, SEXP threadsSEXP) {
+    try {
+        return groupRows(as<std::string>(name_spaceSEXP), as<std::string>(matNameSEXP), as<IntegerVector>(groupsSEXP),
+                         as<int>(ngroupsSEXP), as<std::string>(indexNameSEXP), as<std::string>(regroupNameSEXP),
+                         as<int>(threadsSEXP));
+    } catch (std::exception &e) {
+        Rf_error("groupRows error: %s", e.what());
+    } catch (...) {
+        Rf_error("groupRows unknown error");
+    }
+}
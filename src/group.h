@@ -0,0 +1,32 @@
+#pragma once
+#include <Rcpp.h>
+
+using namespace Rcpp;
+
+/**
+ * Sorts the rows of a shared matrix by group into a shared index: one counting sort of the row numbers, the rows
+ * themselves are not copied. The index is registered as a column of the 1-based row numbers (as doubles), the rows of
+ * group g at the positions start[g], ..., start[g] + size[g] - 1 in their original order. Rows without group (NA) are
+ * left out.
+ *
+ * Optionally the rows are also regrouped physically into a new shared matrix in the order of the index, so that every
+ * group is a block of contiguous rows (see retrieveTile); the columns are gathered on a pool of threads.
+ *
+ * @param name_space        A string identifying the memory space we are working in.
+ * @param matName           The name of the shared double matrix inside the memory space.
+ * @param groups            The group (1, ..., ngroups or NA) of every row.
+ * @param ngroups           The number of groups.
+ * @param indexName         The name under which the index gets registered.
+ * @param regroupName       The name under which the regrouped matrix gets registered; empty for none.
+ * @param threads           Number of threads (0 = all available).
+ *
+ * @result  List with the 1-based start and the size of every group in the index.
+ */
+List groupRows(std::string name_space, std::string matName, IntegerVector groups, int ngroups, std::string indexName,
+               std::string regroupName, int threads);
+
+/**
+ * Wrapper function for groupRows above.
+ */
+extern "C" SEXP C_groupRows(SEXP name_spaceSEXP, SEXP matNameSEXP, SEXP groupsSEXP, SEXP ngroupsSEXP, SEXP indexNameSEXP,
+                            SEXP regroupNameSEXP, SEXP threadsSEXP);
@@ -0,0 +1,284 @@
+#include "ingest.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+
+#include "memory_page.h"
+#include "parallel.h"
+#include "shared_memory.h"
+
+namespace {
+
+// bytes a thread reads at once from a binary file
+const std::size_t READ_CHUNK_BYTES = 8 << 20;
+// csv chunks per thread, so that chunks with long lines balance out
+const std::size_t CHUNKS_PER_THREAD = 4;
+
+std::size_t file_size(const std::string& path) {
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    if (!in) throw std::runtime_error("Could not open file " + path);
+    return static_cast<std::size_t>(in.tellg());
+}
+
+bool little_endian() {
+    const std::uint16_t one = 1;
+    unsigned char first;
+    std::memcpy(&first, &one, 1);
+    return first == 1;
+}
+
+// [begin, end) without surrounding blanks and quotes
+void trim_field(const char*& begin, const char*& end) {
+    while (begin < end && (*begin == ' ' || *begin == '\t')) begin++;
+    while (end > begin && (end[-1] == ' ' || end[-1] == '\t' || end[-1] == '\r')) end--;
+    if (end - begin >= 2 && (*begin == '"' || *begin == '\'') && end[-1] == *begin) {
+        begin++;
+        end--;
+    }
+}
+
+// the end of the line starting at begin (the position of '\n' or end)
+const char* line_end(const char* begin, const char* end) {
+    const char* nl = static_cast<const char*>(std::memchr(begin, '\n', end - begin));
+    return nl == nullptr ? end : nl;
+}
+
+bool blank_line(const char* begin, const char* end) {
+    trim_field(begin, end);
+    return begin == end;
+}
+
+// the fields of a line split at sep
+void split_line(const char* begin, const char* end, char sep, std::vector<std::pair<const char*, const char*>>& fields) {
+    fields.clear();
+    const char* field = begin;
+    for (const char* p = begin; p < end; p++) {
+        if (*p == sep) {
+            fields.push_back({field, p});
+            field = p + 1;
+        }
+    }
+    fields.push_back({field, end});
+}
+
+// parses a numeric field; empty fields and NA are missing values
+bool parse_field(const char* begin, const char* end, double na, double& value) {
+    trim_field(begin, end);
+    std::size_t len = end - begin;
+    if (len == 0 || (len == 2 && begin[0] == 'N' && begin[1] == 'A')) {
+        value = na;
+        return true;
+    }
+    char buffer[128];
+    if (len >= sizeof(buffer)) return false;
+    std::memcpy(buffer, begin, len);
+    buffer[len] = '\0';
+    char* parsed;
+    value = std::strtod(buffer, &parsed);
+    return parsed == buffer + len;
+}
+
+void read_binary(const std::string& path, std::size_t offset, double* out, std::size_t bytes, int threads) {
+    std::size_t nchunks = (bytes + READ_CHUNK_BYTES - 1) / READ_CHUNK_BYTES;
+#ifdef _WIN32
+    parallel_for(nchunks, threads, [&](std::size_t c) {
+        std::size_t begin = c * READ_CHUNK_BYTES;
+        std::size_t len = std::min(READ_CHUNK_BYTES, bytes - begin);
+        std::ifstream in(path, std::ios::binary);
+        in.seekg(static_cast<std::streamoff>(offset + begin));
+        if (!in.read(static_cast<char*>(static_cast<void*>(out)) + begin, static_cast<std::streamsize>(len))) {
+            throw std::runtime_error("Could not read " + path);
+        }
+    });
+#else
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd == -1) throw std::runtime_error("Could not open file " + path);
+    try {
+        parallel_for(nchunks, threads, [&](std::size_t c) {
+            std::size_t begin = c * READ_CHUNK_BYTES;
+            std::size_t end = std::min(bytes, begin + READ_CHUNK_BYTES);
+            char* dest = static_cast<char*>(static_cast<void*>(out));
+            while (begin < end) {
+                ssize_t n = pread(fd, dest + begin, end - begin, static_cast<off_t>(offset + begin));
+                if (n < 0 && errno == EINTR) continue;
+                if (n <= 0) throw std::runtime_error("Could not read " + path);
+                begin += static_cast<std::size_t>(n);
+            }
+        });
+    } catch (...) {
+        close(fd);
+        throw;
+    }
+    close(fd);
+#endif
+    if (!little_endian()) {
+        std::size_t n = bytes / sizeof(double);
+        parallel_for(n, threads, [&](std::size_t i) {
+            unsigned char* b = static_cast<unsigned char*>(static_cast<void*>(out + i));
+            std::reverse(b, b + sizeof(double));
+        }, 1 << 16);
+    }
+}
+
+}
+
+List registerFromFile(std::string name_space, std::string varname, std::string path, std::string format,
+                      bool header, std::string sep, double ncol, double offset, int threads) {
+#ifdef _WIN32
+    // For windows we prepend the namespace identifier by "Local\\" because otherwise the shared memory is shared system-wide (instead of user-wide) which needs admin privileges
+    name_space = "Local\\" + name_space;
+#endif
+    std::string page = name_space + "." + varname;
+    std::string metaPage = name_space + ".md." + varname;
+    if (pages.find(page) != pages.end()) stop("Variable " + varname + " is already registered!");
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::size_t bytes = file_size(path);
+
+    std::size_t nrow = 0, cols = 0;
+    CharacterVector names;
+    bool hasNames = false;
+    double* out = nullptr;
+
+    if (format == "binary") {
+        if (!(ncol >= 1) || !(offset >= 0)) stop("ncol has to be positive and offset non-negative");
+        cols = static_cast<std::size_t>(ncol);
+        std::size_t skip = static_cast<std::size_t>(offset);
+        if (skip > bytes || (bytes - skip) % (cols * sizeof(double)) != 0) {
+            stop("The size of " + path + " (minus offset) is not a multiple of ncol doubles!");
+        }
+        nrow = (bytes - skip) / (cols * sizeof(double));
+        if (nrow == 0) stop(path + " holds no data!");
+
+        out = allocMatrixPage(page, metaPage, nrow, cols);
+        try {
+            read_binary(path, skip, out, nrow * cols * sizeof(double), threads);
+        } catch (...) {
+            releasePage(page);
+            throw;
+        }
+    } else if (format == "csv") {
+        if (sep.size() != 1) stop("sep has to be a single character");
+        if (bytes == 0) stop(path + " is empty!");
+        if (threads <= 0) threads = static_cast<int>(default_threads());
+
+        // the file is parsed from the page cache; the mapping adds no private memory
+        MemoryPage file;
+        file.map_file(path, bytes, false);
+        const char* text = static_cast<const char*>(static_cast<const void*>(file.data()));
+        const char* end = text + bytes;
+
+        // the first non-blank line defines the number of columns (and their names)
+        std::vector<std::pair<const char*, const char*>> fields;
+        const char* first = text;
+        while (first < end && blank_line(first, line_end(first, end))) first = line_end(first, end) + 1;
+        if (first >= end) stop(path + " holds no data!");
+        const char* firstEnd = line_end(first, end);
+        split_line(first, firstEnd, sep[0], fields);
+        cols = fields.size();
+        const char* data = first;
+        if (header) {
+            names = CharacterVector(cols);
+            for (std::size_t j = 0; j < cols; j++) {
+                const char* b = fields[j].first;
+                const char* e = fields[j].second;
+                trim_field(b, e);
+                names[j] = std::string(b, e);
+            }
+            hasNames = true;
+            data = std::min(firstEnd + 1, end);
+        }
+
+        // chunks end at line boundaries
+        std::size_t nchunks = static_cast<std::size_t>(threads) * CHUNKS_PER_THREAD;
+        std::size_t step = std::max<std::size_t>((end - data) / nchunks, 1);
+        std::vector<const char*> bounds(1, data);
+        for (std::size_t c = 1; c < nchunks; c++) {
+            const char* b = data + c * step;
+            if (b <= bounds.back()) continue;
+            if (b >= end) break;
+            b = std::min(line_end(b - 1, end) + 1, end);
+            if (b > bounds.back() && b < end) bounds.push_back(b);
+        }
+        bounds.push_back(end);
+        nchunks = bounds.size() - 1;
+
+        // first pass: the rows of every chunk, hence the row every chunk starts at
+        std::vector<std::size_t> rowStart(nchunks + 1, 0);
+        parallel_for(nchunks, threads, [&](std::size_t c) {
+            std::size_t rows = 0;
+            for (const char* l = bounds[c]; l < bounds[c + 1]; l = line_end(l, bounds[c + 1]) + 1) {
+                if (!blank_line(l, line_end(l, bounds[c + 1]))) rows++;
+            }
+            rowStart[c + 1] = rows;
+        });
+        for (std::size_t c = 0; c < nchunks; c++) rowStart[c + 1] += rowStart[c];
+        nrow = rowStart[nchunks];
+        if (nrow == 0) stop(path + " holds no data!");
+
+        // second pass: every chunk writes its own row range of each column
+        out = allocMatrixPage(page, metaPage, nrow, cols);
+        const double na = NA_REAL;
+        const char delimiter = sep[0];
+        try {
+            parallel_for(nchunks, threads, [&](std::size_t c) {
+                std::vector<std::pair<const char*, const char*>> f;
+                std::size_t row = rowStart[c];
+                for (const char* l = bounds[c]; l < bounds[c + 1]; l = line_end(l, bounds[c + 1]) + 1) {
+                    const char* le = line_end(l, bounds[c + 1]);
+                    if (blank_line(l, le)) continue;
+                    split_line(l, le, delimiter, f);
+                    if (f.size() != cols) {
+                        throw std::runtime_error("Data row " + std::to_string(row + 1) + " has " + std::to_string(f.size()) +
+                                                 " fields instead of " + std::to_string(cols) + ".");
+                    }
+                    for (std::size_t j = 0; j < cols; j++) {
+                        if (!parse_field(f[j].first, f[j].second, na, out[j * nrow + row])) {
+                            throw std::runtime_error("Data row " + std::to_string(row + 1) + ", column " +
+                                                     std::to_string(j + 1) + " is not numeric.");
+                        }
+                    }
+                    row++;
+                }
+            });
+        } catch (...) {
+            releasePage(page);
+            throw;
+        }
+    } else {
+        stop("Unknown format " + format + ", use 'csv' or 'binary'.");
+    }
+
+    // the page was filled in place, its registration time is the time of the ingest; only now may viewers attach
+    try {
+        pages[page]->header()->memcpy_secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        completeMatrixPage(page);
+    } catch (...) {
+        releasePage(page);
+        throw;
+    }
+
+    return List::create(
+        Named("nrow") = static_cast<double>(nrow),
+        Named("ncol") = static_cast<double>(cols),
+        Named("colnames") = hasNames ? static_cast<SEXP>(names) : R_NilValue
+    );
+}
+
+extern "C" SEXP C_registerFromFile(SEXP name_spaceSEXP, SEXP varnameSEXP, SEXP pathSEXP, SEXP formatSEXP,
+                                   SEXP headerSEXP, SEXP sepSEXP, SEXP ncolSEXP, SEXP offsetSEXP, SEXP threadsSEXP) {
+    try {
+        return registerFromFile(as<std::string>(name_spaceSEXP), as<std::string>(varnameSEXP), as<std::string>(pathSEXP),
+                                as<std::string>(formatSEXP), as<bool>(headerSEXP), as<std::string>(sepSEXP),
+                                as<double>(ncolSEXP), as<double>(offsetSEXP), as<int>(threadsSEXP));
+    } catch (std::exception &e) {
+        Rf_error("registerFromFile error: %s", e.what());
+    } catch (...) {
+        Rf_error("registerFromFile unknown error");
+    }
+}
@@ -0,0 +1,32 @@
+#pragma once
+#include <Rcpp.h>
+
+using namespace Rcpp;
+
+/**
+ * Registers a double matrix read straight from a file into a new shared memory page, without an intermediate copy
+ * in the R heap. The page is sized first and then filled by a pool of threads:
+ *  - "csv": the file is mapped read-only, split into chunks at line boundaries, the rows of every chunk are counted
+ *    and then every thread parses its chunks into its own row range of each column.
+ *  - "binary": raw little-endian doubles in column-major order, read chunk-wise with positioned reads.
+ *
+ * @param name_space        A string identifying the memory space we are working in.
+ * @param varname           The name under which the matrix gets registered.
+ * @param path              Path of the file.
+ * @param format            "csv" or "binary".
+ * @param header            csv: whether the first line holds the column names.
+ * @param sep               csv: the field separator.
+ * @param ncol              binary: the number of columns; the number of rows follows from the size of the file.
+ * @param offset            binary: number of bytes to skip at the start of the file.
+ * @param threads           Number of threads (0 = all available).
+ *
+ * @result  List with the dimensions nrow, ncol and the column names (NULL if there are none).
+ */
+List registerFromFile(std::string name_space, std::string varname, std::string path, std::string format,
+                      bool header, std::string sep, double ncol, double offset, int threads);
+
+/**
+ * Wrapper function for registerFromFile above.
+ */
+extern "C" SEXP C_registerFromFile(SEXP name_spaceSEXP, SEXP varnameSEXP, SEXP pathSEXP, SEXP formatSEXP,
+                                   SEXP headerSEXP, SEXP sepSEXP, SEXP ncolSEXP, SEXP offsetSEXP, SEXP threadsSEXP);
@@ -2,11 +2,16 @@
 #include "register.h"
 #include "retrieve.h"
 #include "c_mutualinfo.h"
+#include "mi_shared.h"
+#include "ingest.h"
+#include "group.h"
+#include "update.h"
 
 // The actual definition of the declared ALTREP classes.
 R_altrep_class_t altrep_matrix_class = {0};
 R_altrep_class_t altrep_vector_class = {0};
 R_altrep_class_t altrep_list_class = {0};
+R_altrep_class_t altrep_tile_class = {0};
 
 extern "C" {
 
@@ -14,14 +19,43 @@ extern "C" {
      * Here we define the wrappers and callable functions with their number of parameters by hand (instead of using Rcpp::export)
      */
     static const R_CallMethodDef CallEntries[] = {
-        {"C_registerVariables", (DL_FUNC) &C_registerVariables, 2},
-        {"C_retrieveViews", (DL_FUNC) &C_retrieveViews, 2},
+        {"C_registerVariables", (DL_FUNC) &C_registerVariables, 5},
+        {"C_retrieveViews", (DL_FUNC) &C_retrieveViews, 4},
+        {"C_retrieveTile", (DL_FUNC) &C_retrieveTile, 4},
+        {"C_registerVariablesAsync", (DL_FUNC) &C_registerVariablesAsync, 3},
+        {"C_readyVariablesAsync", (DL_FUNC) &C_readyVariablesAsync, 1},
+        {"C_waitVariablesAsync", (DL_FUNC) &C_waitVariablesAsync, 1},
+        {"C_publishVariable", (DL_FUNC) &C_publishVariable, 4},
         {"C_releaseVariables", (DL_FUNC) &C_releaseVariables, 2},
         {"C_releaseViews", (DL_FUNC) &C_releaseViews, 2},
         {"C_retrieveMetadata", (DL_FUNC) &C_retrieveMetadata, 2},
         {"C_viewList", (DL_FUNC) &C_viewList, 0},
         {"C_pageList", (DL_FUNC) &C_pageList, 0},
+        {"C_pageStats", (DL_FUNC) &C_pageStats, 0},
+        {"C_viewStats", (DL_FUNC) &C_viewStats, 0},
+        {"C_namespaceCatalog", (DL_FUNC) &C_namespaceCatalog, 1},
+        {"C_memshareReclaim", (DL_FUNC) &C_memshareReclaim, 1},
+        {"C_memshareQuota", (DL_FUNC) &C_memshareQuota, 2},
+        {"C_memsharePool", (DL_FUNC) &C_memsharePool, 1},
+        {"C_memshareArena", (DL_FUNC) &C_memshareArena, 3},
+        {"C_memshareNuma", (DL_FUNC) &C_memshareNuma, 2},
+        {"C_snapshotVariable", (DL_FUNC) &C_snapshotVariable, 4},
+        {"C_restoreVariable", (DL_FUNC) &C_restoreVariable, 4},
+        {"C_registerFromFile", (DL_FUNC) &C_registerFromFile, 9},
+        {"C_updateVariable", (DL_FUNC) &C_updateVariable, 6},
+        {"C_readVariable", (DL_FUNC) &C_readVariable, 5},
+        {"C_variableVersion", (DL_FUNC) &C_variableVersion, 2},
         {"C_mutualinfo", (DL_FUNC) &C_mutualinfo, 2},
+        {"C_mutualinfo_continuous", (DL_FUNC) &C_mutualinfo_continuous, 5},
+        {"C_mutualinfo_mixed", (DL_FUNC) &C_mutualinfo_mixed, 5},
+        {"C_mutualinfo_discrete", (DL_FUNC) &C_mutualinfo_discrete, 2},
+        {"C_mutualinfoMatrix", (DL_FUNC) &C_mutualinfoMatrix, 10},
+        {"C_mutualinfoTarget", (DL_FUNC) &C_mutualinfoTarget, 8},
+        {"C_mutualinfoStreamUpdate", (DL_FUNC) &C_mutualinfoStreamUpdate, 4},
+        {"C_mutualinfoStreamMerge", (DL_FUNC) &C_mutualinfoStreamMerge, 3},
+        {"C_mutualinfoStreamCounts", (DL_FUNC) &C_mutualinfoStreamCounts, 4},
+        {"C_mutualinfoStreamValue", (DL_FUNC) &C_mutualinfoStreamValue, 2},
+        {"C_groupRows", (DL_FUNC) &C_groupRows, 7},
         {NULL, NULL, 0}
     };
     
@@ -49,6 +83,12 @@ extern "C" {
         R_set_altvec_Dataptr_method(altrep_matrix_class, altrep_matrix_dataptr);
         R_set_altvec_Dataptr_or_null_method(altrep_matrix_class, altrep_matrix_dataptr_or_null);
 
+        // answered from the column statistics if the variable was registered with them
+        R_set_altreal_Sum_method(altrep_matrix_class, altrep_matrix_sum);
+        R_set_altreal_Min_method(altrep_matrix_class, altrep_matrix_min);
+        R_set_altreal_Max_method(altrep_matrix_class, altrep_matrix_max);
+        R_set_altreal_No_NA_method(altrep_matrix_class, altrep_matrix_no_na);
+
 
 
         altrep_vector_class = R_make_altreal_class("altrep_vector", "memshare", dll);
@@ -66,6 +106,25 @@ extern "C" {
         R_set_altvec_Dataptr_method(altrep_vector_class, altrep_vector_dataptr);
         R_set_altvec_Dataptr_or_null_method(altrep_vector_class, altrep_vector_dataptr_or_null);
 
+        R_set_altreal_Sum_method(altrep_vector_class, altrep_vector_sum);
+        R_set_altreal_Min_method(altrep_vector_class, altrep_vector_min);
+        R_set_altreal_Max_method(altrep_vector_class, altrep_vector_max);
+        R_set_altreal_No_NA_method(altrep_vector_class, altrep_vector_no_na);
+
+
+
+
+
+        altrep_tile_class = R_make_altreal_class("altrep_tile", "memshare", dll);
+
+        R_set_altrep_Length_method(altrep_tile_class, altrep_tile_length);
+        R_set_altrep_Inspect_method(altrep_tile_class, altrep_tile_inspect);
+
+        R_set_altreal_Elt_method(altrep_tile_class, altrep_tile_real_elt);
+        R_set_altreal_Get_region_method(altrep_tile_class, altrep_tile_get_region);
+        R_set_altvec_Dataptr_method(altrep_tile_class, altrep_tile_dataptr);
+        R_set_altvec_Dataptr_or_null_method(altrep_tile_class, altrep_tile_dataptr_or_null);
+
 
 
 
@@ -1,13 +1,14 @@
 #include "memory_page.h"
 
 
-void MemoryPage::alloc(const std::string& name, size_t byteSize) {
+void MemoryPage::alloc(const std::string& name, size_t byteSize, bool populate) {
     // set name, size and viewership/ownership as is.
     name_ = name;
     size_ = byteSize;
     is_view = false;
 #ifdef _WIN32
-    // for windows create a file mapping and retrieve a handle to it.
+    // for windows create a file mapping and retrieve a handle to it; its pages are committed on the first touch.
+    (void) populate;
 //MCT correction in 1.0.3
   ULONGLONG maxSize = static_cast<ULONGLONG>(size_);
   DWORD maxSizeLow  = static_cast<DWORD>(maxSize & 0xFFFFFFFFull);
@@ -54,28 +55,69 @@ void MemoryPage::alloc(const std::string& name, size_t byteSize) {
         //throw std::runtime_error("Failed to open shared memory.");
     }
 
-    if (ftruncate(fd_, size_) == -1) {
+    // on failure the section has to be removed again, otherwise it leaks
+    auto fail = [&](const std::string& message) {
         close(fd_);
-        throw std::runtime_error("Failed to set size of shared memory.");
+        fd_ = -1;
+        ptr_ = nullptr;
+        shm_unlink(name.c_str());
+        throw std::runtime_error(message);
+    };
+
+    // refuse what does not fit into the shared memory file system instead of dying with SIGBUS on the first touch
+    struct statvfs fs;
+    if (fstatvfs(fd_, &fs) == 0 && static_cast<unsigned long long>(fs.f_bavail) * fs.f_frsize < size_) {
+        fail("Not enough shared memory for " + name + ": " + std::to_string(size_) + " bytes requested, " +
+             std::to_string(static_cast<unsigned long long>(fs.f_bavail) * fs.f_frsize) + " bytes available.");
     }
 
-    ptr_ = mmap(NULL, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if (ftruncate(fd_, size_) == -1) {
+        fail("Failed to set size of shared memory.");
+    }
+
+#ifdef __linux__
+    // reserve the backing store up front; file systems without support for it keep the lazy allocation
+    if (size_ > 0) {
+        int err = posix_fallocate(fd_, 0, size_);
+        if (err == ENOSPC || err == EFBIG) {
+            fail("Not enough shared memory for " + name + ": could not reserve " + std::to_string(size_) + " bytes.");
+        }
+    }
+#endif
+
+    int flags = MAP_SHARED;
+#ifdef MAP_POPULATE
+    if (populate) flags |= MAP_POPULATE;
+#endif
+    ptr_ = mmap(NULL, size_, PROT_READ | PROT_WRITE, flags, fd_, 0);
     if (ptr_ == MAP_FAILED) {
-        close(fd_);
-        throw std::runtime_error("Failed to map shared memory.");
+        fail("Failed to map shared memory.");
     }
 #endif
 }
 
-void MemoryPage::view(const std::string& name, size_t byteSize) {
-    // set name, size and view as is.
+size_t MemoryPage::granularity() {
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return static_cast<size_t>(info.dwAllocationGranularity);
+#else
+    return static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#endif
+}
+
+void MemoryPage::view(const std::string& name, size_t byteSize, bool writable, size_t offset, bool copyOnWrite) {
+    // set name, size and view as is; a window is mapped from the preceding aligned offset
     name_ = name;
-    size_ = byteSize;
+    delta_ = offset % granularity();
+    offset -= delta_;
+    size_ = byteSize + delta_;
     is_view = true;
 #ifdef _WIN32
     // for windows open an already existing file mapping and retrieve a handle to it.
+    DWORD access = copyOnWrite ? FILE_MAP_COPY : writable ? (FILE_MAP_READ | FILE_MAP_WRITE) : FILE_MAP_READ;
     hMapFile_ = OpenFileMappingA(
-        FILE_MAP_READ,
+        access,
         FALSE,
         name.c_str()
     );
@@ -85,10 +127,10 @@ void MemoryPage::view(const std::string& name, size_t byteSize) {
 
     ptr_ = MapViewOfFile(
         hMapFile_,
-        FILE_MAP_READ,
-        0,
-        0,
-        byteSize
+        access,
+        static_cast<DWORD>((static_cast<ULONGLONG>(offset) >> 32) & 0xFFFFFFFFull),
+        static_cast<DWORD>(static_cast<ULONGLONG>(offset) & 0xFFFFFFFFull),
+        size_
     );
 
     if (ptr_ == NULL) {
@@ -96,14 +138,176 @@ void MemoryPage::view(const std::string& name, size_t byteSize) {
         throw std::runtime_error("Could not map view of file.");
     }
 #else
-    // for ubuntu open an already existing shm and mmap it.
-    fd_ = shm_open(name.c_str(), O_RDONLY, 0666);
+    // for ubuntu open an already existing shm and mmap it; a private mapping is writable on a read-only descriptor
+    fd_ = shm_open(name.c_str(), writable && !copyOnWrite ? O_RDWR : O_RDONLY, 0666);
     if (fd_ == -1)
         throw std::runtime_error("Failed to open shared memory.");
 
-    ptr_ = mmap(0, byteSize, PROT_READ, MAP_SHARED, fd_, 0);
-    if (ptr_ == MAP_FAILED)
+    ptr_ = mmap(0, size_, writable || copyOnWrite ? (PROT_READ | PROT_WRITE) : PROT_READ, copyOnWrite ? MAP_PRIVATE : MAP_SHARED,
+                fd_, static_cast<off_t>(offset));
+    if (ptr_ == MAP_FAILED) {
+        ptr_ = nullptr;
         throw std::runtime_error("Failed to map shared memory.");
+    }
+#endif
+}
+
+bool MemoryPage::open(const std::string& name, size_t byteSize, bool create) {
+    // such a section is never removed by the destructor, hence it is treated like a view
+    name_ = name;
+    size_ = byteSize;
+    is_view = true;
+    bool created = false;
+#ifdef _WIN32
+    ULONGLONG maxSize = static_cast<ULONGLONG>(size_);
+    if (create) {
+        hMapFile_ = CreateFileMappingA(
+            INVALID_HANDLE_VALUE,
+            NULL,
+            PAGE_READWRITE,
+            static_cast<DWORD>((maxSize >> 32) & 0xFFFFFFFFull),
+            static_cast<DWORD>(maxSize & 0xFFFFFFFFull),
+            name.c_str());
+        created = hMapFile_ != NULL && GetLastError() != ERROR_ALREADY_EXISTS;
+    } else {
+        hMapFile_ = OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, name.c_str());
+    }
+    if (hMapFile_ == NULL)
+        throw std::runtime_error("Could not open file mapping " + name);
+
+    ptr_ = MapViewOfFile(hMapFile_, FILE_MAP_ALL_ACCESS, 0, 0, byteSize);
+    if (ptr_ == NULL) {
+        CloseHandle(hMapFile_);
+        hMapFile_ = nullptr;
+        throw std::runtime_error("Could not map view of file.");
+    }
+#else
+    if (create) {
+        fd_ = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0666);
+        if (fd_ != -1) {
+            created = true;
+            if (ftruncate(fd_, size_) == -1) {
+                close(fd_);
+                fd_ = -1;
+                shm_unlink(name.c_str());
+                throw std::runtime_error("Failed to set size of shared memory.");
+            }
+        } else if (errno != EEXIST) {
+            throw std::runtime_error("Failed to open shared memory " + name);
+        }
+    }
+    if (!created) {
+        fd_ = shm_open(name.c_str(), O_RDWR, 0666);
+        if (fd_ == -1)
+            throw std::runtime_error("Failed to open shared memory " + name);
+        // the creator might not have set the size yet
+        struct stat st;
+        for (int i = 0; ; i++) {
+            if (fstat(fd_, &st) == -1 || i > 1000) {
+                close(fd_);
+                fd_ = -1;
+                throw std::runtime_error("Shared memory " + name + " was not initialized.");
+            }
+            if (static_cast<size_t>(st.st_size) >= byteSize) break;
+            usleep(1000);
+        }
+    }
+
+    ptr_ = mmap(NULL, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if (ptr_ == MAP_FAILED) {
+        ptr_ = nullptr;
+        close(fd_);
+        fd_ = -1;
+        throw std::runtime_error("Failed to map shared memory.");
+    }
+#endif
+    return created;
+}
+
+void MemoryPage::unlink(const std::string& name) {
+#ifndef _WIN32
+    shm_unlink(name.c_str());
+#endif
+}
+
+void MemoryPage::map_file(const std::string& path, size_t byteSize, bool writable, size_t offset, bool copyOnWrite) {
+    // a file-backed section is never removed by the destructor, hence it is treated like a view
+    name_ = path;
+    delta_ = offset % granularity();
+    offset -= delta_;
+    size_ = byteSize + delta_;
+    is_view = true;
+#ifdef _WIN32
+    if (copyOnWrite) writable = false;
+    HANDLE file = CreateFileA(
+        path.c_str(),
+        writable ? (GENERIC_READ | GENERIC_WRITE) : GENERIC_READ,
+        FILE_SHARE_READ | FILE_SHARE_WRITE,
+        NULL,
+        OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL,
+        NULL);
+    if (file == INVALID_HANDLE_VALUE)
+        throw std::runtime_error("Could not open file " + path);
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize) || static_cast<ULONGLONG>(fileSize.QuadPart) < static_cast<ULONGLONG>(offset + size_)) {
+        CloseHandle(file);
+        throw std::runtime_error("File " + path + " is smaller than expected.");
+    }
+
+    // the mapping keeps the file open
+    hMapFile_ = CreateFileMappingA(file, NULL, copyOnWrite ? PAGE_WRITECOPY : writable ? PAGE_READWRITE : PAGE_READONLY, 0, 0, NULL);
+    CloseHandle(file);
+    if (hMapFile_ == NULL)
+        throw std::runtime_error("Could not create file mapping of " + path);
+
+    ptr_ = MapViewOfFile(hMapFile_, copyOnWrite ? FILE_MAP_COPY : writable ? FILE_MAP_ALL_ACCESS : FILE_MAP_READ,
+                         static_cast<DWORD>((static_cast<ULONGLONG>(offset) >> 32) & 0xFFFFFFFFull),
+                         static_cast<DWORD>(static_cast<ULONGLONG>(offset) & 0xFFFFFFFFull), size_);
+    if (ptr_ == NULL) {
+        CloseHandle(hMapFile_);
+        hMapFile_ = nullptr;
+        throw std::runtime_error("Could not map view of file " + path);
+    }
+#else
+    if (copyOnWrite) writable = false;
+    fd_ = ::open(path.c_str(), writable ? O_RDWR : O_RDONLY);
+    if (fd_ == -1)
+        throw std::runtime_error("Could not open file " + path);
+
+    struct stat st;
+    if (fstat(fd_, &st) == -1 || static_cast<size_t>(st.st_size) < offset + size_) {
+        close(fd_);
+        fd_ = -1;
+        throw std::runtime_error("File " + path + " is smaller than expected.");
+    }
+
+    ptr_ = mmap(NULL, size_, writable || copyOnWrite ? (PROT_READ | PROT_WRITE) : PROT_READ, copyOnWrite ? MAP_PRIVATE : MAP_SHARED,
+                fd_, static_cast<off_t>(offset));
+    if (ptr_ == MAP_FAILED) {
+        ptr_ = nullptr;
+        close(fd_);
+        fd_ = -1;
+        throw std::runtime_error("Failed to map file " + path);
+    }
+#endif
+}
+
+void MemoryPage::map_private(const PageSource& source, size_t byteSize) {
+    if (source.path.empty()) {
+        view(source.name, byteSize, false, source.offset, true);
+    } else {
+        map_file(source.path, byteSize, false, source.offset, true);
+    }
+}
+
+void MemoryPage::sync() {
+    if (!ptr_) return;
+#ifdef _WIN32
+    FlushViewOfFile(ptr_, size_);
+#else
+    msync(ptr_, size_, MS_SYNC);
 #endif
 }
 
@@ -129,7 +333,7 @@ MemoryPage::~MemoryPage() {
 }
 
 double* MemoryPage::data() {
-    return static_cast<double*>(ptr_);
+    return static_cast<double*>(static_cast<void*>(static_cast<char*>(ptr_) + delta_));
 }
 
 std::string MemoryPage::get_name() const {
@@ -4,6 +4,7 @@
 #include <stdexcept>
 #include <string>
 #include <cstdint>   // uint64_t, MCT correction in 1.0.3
+#include <cerrno>
 
 #ifdef _WIN32
 //MCT correction in 1.0.3
@@ -15,10 +16,21 @@
 #else
 #include <sys/mman.h>
 #include <sys/stat.h> /* For mode constants */
+#include <sys/statvfs.h>
 #include <fcntl.h>    /* For O_* constants */
 #include <unistd.h>
 #endif
 
+/**
+ * Where the data of a view lies, for mapping it once more: the name of its section (or the path of its file for
+ * file-backed pages) and the offset of the data in it.
+ */
+struct PageSource {
+  std::string name;
+  std::string path;
+  size_t offset = 0;
+};
+
 /**
  * A Memory page is the raw memory section in RAM which is shared among different processes.
  * 
@@ -31,15 +43,60 @@ public:
    * 
    * @param name        The name of the section
    * @param byteSize    The size in bytes of the section
+   * @param populate    Whether to map all pages up front (Linux), which saves a page fault per page on the first write
    */
-  void alloc(const std::string& name, size_t byteSize);
+  void alloc(const std::string& name, size_t byteSize, bool populate = false);
   /**
    * Retrieves viewership (a handle) of a shared memory section by name.
    * 
    * @param name        The name of the section
    * @param byteSize    The size in bytes of the section
+   * @param writable    Whether the view is mapped writable (only used for the bookkeeping in metadata sections)
+   * @param offset      Only the window of byteSize bytes starting at this offset is mapped; see granularity
+   * @param copyOnWrite Map the section privately: it is writable, but written pages are copied for this process
+   *                    and never reach the section (MAP_PRIVATE, FILE_MAP_COPY on Windows); writable is ignored then
+   */
+  void view(const std::string& name, size_t byteSize, bool writable = false, size_t offset = 0, bool copyOnWrite = false);
+  /**
+   * Maps a shared memory section writable, creating it if it does not exist yet (and create is set).
+   * Unlike alloc the section is not removed when this handle is destroyed; see unlink.
+   * 
+   * @param name        The name of the section
+   * @param byteSize    The size in bytes of the section
+   * @param create      Whether to create the section if it does not exist
+   * 
+   * @result  Whether the section was created by this call (it is zero-filled then).
+   */
+  bool open(const std::string& name, size_t byteSize, bool create);
+  /**
+   * Removes the name of a section created via open; existing handles stay valid.
+   * On Windows sections vanish with their last handle and this is a no-op.
+   */
+  static void unlink(const std::string& name);
+  /**
+   * Maps an existing file as the section (file-backed page), e.g. a snapshot on local disk. The file is never
+   * removed by the destructor; writes of a writable mapping go back to the file.
+   * 
+   * @param path        Path of the file
+   * @param byteSize    The size in bytes of the section; the file has to be at least this large
+   * @param writable    Whether the mapping is writable
+   * @param offset      Only the window of byteSize bytes starting at this offset is mapped; see granularity
+   * @param copyOnWrite Map the file privately, see view
+   */
+  void map_file(const std::string& path, size_t byteSize, bool writable, size_t offset = 0, bool copyOnWrite = false);
+  /**
+   * Maps byteSize bytes of the data of a view privately (see view and map_file with copyOnWrite).
+   */
+  void map_private(const PageSource& source, size_t byteSize);
+  /**
+   * The alignment of the start of a mapping (the page size, 64 KB on Windows). A window at another offset is mapped
+   * from the preceding aligned offset on; data() points to the requested offset nevertheless.
+   */
+  static size_t granularity();
+  /**
+   * Writes the changes of a file-backed mapping back to its file and waits for it.
    */
-  void view(const std::string& name, size_t byteSize);
+  void sync();
 
   /**
    * Gives the handle back to the OS in order for it to track if there still are open handles.
@@ -67,6 +124,7 @@ private:
   std::string name_;
   size_t size_ = 0; // size in bytes, MCT correction
   void* ptr_ = nullptr;
+  size_t delta_ = 0; // distance of the requested offset from the start of the mapping
   bool is_view = false;
 
 #ifdef _WIN32
@@ -18,15 +18,17 @@ struct ListData { std::size_t n, numDoubles; };
  * The metadata struct encapsulates information about an object.
  * 
  * 
- * The type is either MATRIX, VECTOR or LIST.
+ * The type is either MATRIX, VECTOR, LIST or CODES.
  * 
- * matrix_data, vector_data, list_data contains the metadata of the respective type.
+ * matrix_data, vector_data, list_data contains the metadata of the respective type. CODES are the uint16 grid codes
+ * of mutualinfoMatrix packed into the doubles of a matrix (matrix_data); they are no doubles and hence cannot be viewed.
  */
 struct metadata {
     enum type {
         MATRIX,
         VECTOR,
-        LIST
+        LIST,
+        CODES
     } data_type;
 
     union {
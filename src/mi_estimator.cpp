@@ -0,0 +1,435 @@
+#include "mi_estimator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+MIWorkspace& mi_workspace() {
+    static thread_local MIWorkspace ws;
+    return ws;
+}
+
+// number of pairs (i < j) of the sorted sample with x[j] - x[i] <= d
+static double count_pairs_within(const std::vector<double>& x, double d) {
+    double cnt = 0;
+    std::size_t j = 0;
+    for (std::size_t i = 0; i < x.size(); i++) {
+        while (x[i] - x[j] > d) j++;
+        cnt += static_cast<double>(i - j);
+    }
+    return cnt;
+}
+
+// smallest distance d such that at least target many pairs are within d (bisection on the sorted sample)
+static double pair_distance_quantile(const std::vector<double>& x, double target) {
+    if (count_pairs_within(x, 0) >= target) return 0;
+    double lo = 0, hi = x.back() - x.front();
+    for (int it = 0; it < 100 && hi - lo > 1e-12 * hi; it++) {
+        double mid = 0.5 * (lo + hi);
+        if (count_pairs_within(x, mid) >= target) hi = mid;
+        else lo = mid;
+    }
+    return hi;
+}
+
+double pareto_radius(const double* x, std::size_t n, std::vector<double>& scratch) {
+    const std::size_t maxSamples = 10000;
+    // draw at most maxSamples equidistant observations (deterministic, so that repeated calls agree)
+    double step = n > maxSamples ? static_cast<double>(n) / maxSamples : 1.0;
+    scratch.clear();
+    for (double pos = 0; pos < n; pos += step) {
+        double v = x[static_cast<std::size_t>(pos)];
+        if (std::isfinite(v)) scratch.push_back(v);
+    }
+    if (scratch.size() < 2) return std::numeric_limits<double>::quiet_NaN();
+    std::sort(scratch.begin(), scratch.end());
+
+    double k = static_cast<double>(scratch.size());
+    double numPairs = k * (k - 1) / 2;
+
+    double radius = pair_distance_quantile(scratch, std::max(1.0, std::ceil(0.18 * numPairs)));
+    if (radius <= 0) {
+        // too many ties; take the smallest percentile of the distances that is positive
+        double ties = count_pairs_within(scratch, 0);
+        for (int p = 19; p <= 100 && radius <= 0; p++) {
+            if (p / 100.0 * numPairs > ties)
+                radius = pair_distance_quantile(scratch, std::ceil(p / 100.0 * numPairs));
+        }
+        if (radius <= 0) return std::numeric_limits<double>::quiet_NaN();
+    }
+    if (n > 1024) radius = radius * 4 / std::pow(static_cast<double>(n), 0.2);
+    return radius;
+}
+
+MIGrid make_grid(const double* x, std::size_t n, std::size_t m, std::vector<double>& scratch) {
+    MIGrid grid;
+    grid.m = m;
+    grid.radius = pareto_radius(x, n, scratch);
+
+    double mn = std::numeric_limits<double>::infinity(), mx = -std::numeric_limits<double>::infinity();
+    for (std::size_t i = 0; i < n; i++) {
+        if (!std::isfinite(x[i])) continue;
+        mn = std::min(mn, x[i]);
+        mx = std::max(mx, x[i]);
+    }
+    if (!std::isfinite(grid.radius) || !(mn <= mx)) {
+        grid.radius = std::numeric_limits<double>::quiet_NaN();
+        return grid;
+    }
+    grid.lo = mn - grid.radius;
+    grid.dx = (mx - mn + 2 * grid.radius) / (m - 1);
+    return grid;
+}
+
+void bin_codes(const double* x, std::size_t n, const MIGrid& grid, std::uint16_t* codes) {
+    double maxCode = static_cast<double>(grid.m - 1);
+    for (std::size_t i = 0; i < n; i++) {
+        if (!std::isfinite(x[i])) {
+            codes[i] = MI_MISSING;
+            continue;
+        }
+        double c = std::floor((x[i] - grid.lo) / grid.dx + 0.5);
+        codes[i] = static_cast<std::uint16_t>(std::min(std::max(c, 0.0), maxCode));
+    }
+}
+
+/**
+ * Banded cholesky factorization of Eilers' smoothing matrix I + s^2 D2'D2 + 2 s D1'D1 of size m x m.
+ * The factor is stored as three diagonals l0 (main), l1 (first sub-) and l2 (second subdiagonal).
+ */
+static const double* eilers_factor(std::size_t m, double s, MIWorkspace& ws) {
+    if (ws.band_m == m && ws.band_s == s) return ws.band.data();
+
+    ws.band.assign(3 * m, 0.0);
+    double* a0 = ws.band.data();
+    double* a1 = a0 + m;
+    double* a2 = a1 + m;
+
+    // assemble the symmetric pentadiagonal matrix (lower diagonals only)
+    for (std::size_t i = 0; i < m; i++) a0[i] = 1;
+    for (std::size_t r = 0; r + 1 < m; r++) {
+        // D1 row r: -1, 1 at columns r, r+1
+        a0[r] += 2 * s;
+        a0[r + 1] += 2 * s;
+        a1[r + 1] -= 2 * s;
+    }
+    const double c[3] = {1, -2, 1};
+    for (std::size_t r = 0; r + 2 < m; r++) {
+        // D2 row r: 1, -2, 1 at columns r, r+1, r+2
+        for (int a = 0; a < 3; a++) {
+            a0[r + a] += s * s * c[a] * c[a];
+            if (a >= 1) a1[r + a] += s * s * c[a] * c[a - 1];
+            if (a >= 2) a2[r + a] += s * s * c[a] * c[a - 2];
+        }
+    }
+
+    // in-place cholesky factorization
+    for (std::size_t i = 0; i < m; i++) {
+        if (i >= 2) a2[i] = a2[i] / a0[i - 2];
+        if (i >= 1) a1[i] = (a1[i] - (i >= 2 ? a2[i] * a1[i - 1] : 0)) / a0[i - 1];
+        a0[i] = std::sqrt(a0[i] - a1[i] * a1[i] - a2[i] * a2[i]);
+    }
+
+    ws.band_m = m;
+    ws.band_s = s;
+    return ws.band.data();
+}
+
+/**
+ * Solve the factorized system for k right hand sides of length m.
+ * Element i of right hand side r is located at data[i * strideI + r * strideR]; one of the strides has to be 1.
+ */
+static void eilers_solve(double* data, std::size_t m, std::size_t k, std::size_t strideI, std::size_t strideR,
+                         const double* band) {
+    const double* l0 = band;
+    const double* l1 = band + m;
+    const double* l2 = band + 2 * m;
+    if (strideR == 1) {
+        // the right hand sides are interleaved, sweep over all of them at once
+        for (std::size_t i = 0; i < m; i++) {
+            double* zi = data + i * strideI;
+            const double* z1 = i >= 1 ? zi - strideI : zi;
+            const double* z2 = i >= 2 ? zi - 2 * strideI : zi;
+            double a1 = i >= 1 ? l1[i] : 0, a2 = i >= 2 ? l2[i] : 0;
+            for (std::size_t r = 0; r < k; r++) zi[r] = (zi[r] - a1 * z1[r] - a2 * z2[r]) / l0[i];
+        }
+        for (std::size_t i = m; i-- > 0;) {
+            double* zi = data + i * strideI;
+            const double* z1 = i + 1 < m ? zi + strideI : zi;
+            const double* z2 = i + 2 < m ? zi + 2 * strideI : zi;
+            double a1 = i + 1 < m ? l1[i + 1] : 0, a2 = i + 2 < m ? l2[i + 2] : 0;
+            for (std::size_t r = 0; r < k; r++) zi[r] = (zi[r] - a1 * z1[r] - a2 * z2[r]) / l0[i];
+        }
+        return;
+    }
+    for (std::size_t r = 0; r < k; r++) {
+        double* z = data + r * strideR;
+        for (std::size_t i = 0; i < m; i++) {
+            double v = z[i];
+            if (i >= 1) v -= l1[i] * z[i - 1];
+            if (i >= 2) v -= l2[i] * z[i - 2];
+            z[i] = v / l0[i];
+        }
+        for (std::size_t i = m; i-- > 0;) {
+            double v = z[i];
+            if (i + 1 < m) v -= l1[i + 1] * z[i + 1];
+            if (i + 2 < m) v -= l2[i + 2] * z[i + 2];
+            z[i] = v / l0[i];
+        }
+    }
+}
+
+/**
+ * Mass preserving gaussian smoothing with standard deviation sigma (in grid units) of k vectors of length m.
+ * Element i of vector r is located at data[i * strideI + r * strideR]; one of the strides has to be 1.
+ * The mass that would leave the grid is redistributed onto it, so that the sum of every vector is preserved.
+ */
+static void gauss_smooth(double* data, std::size_t m, std::size_t k, std::size_t strideI, std::size_t strideR,
+                         double sigma, MIWorkspace& ws) {
+    if (!(sigma > 1e-3)) return;
+    std::size_t w = std::min<std::size_t>(m - 1, static_cast<std::size_t>(std::ceil(4 * sigma)));
+
+    // symmetric kernel, kernel[w + d] is the weight at distance d
+    std::vector<double>& kernel = ws.line;
+    kernel.resize(2 * w + 1);
+    for (std::size_t d = 0; d <= w; d++) kernel[w + d] = kernel[w - d] = std::exp(-0.5 * (d / sigma) * (d / sigma));
+
+    // column sums of the truncated convolution matrix
+    std::vector<double>& z = ws.norm;
+    z.assign(m, 0.0);
+    for (std::size_t j = 0; j < m; j++) {
+        std::size_t a = j >= w ? j - w : 0, b = std::min(m - 1, j + w);
+        for (std::size_t i = a; i <= b; i++) z[j] += kernel[w + i - j];
+    }
+
+    std::vector<double>& src = ws.tmp;
+    if (strideR == 1) {
+        // the vectors are interleaved, accumulate whole rows of them
+        src.assign(data, data + m * strideI);
+        std::fill(data, data + m * strideI, 0.0);
+        for (std::size_t j = 0; j < m; j++) {
+            std::size_t a = j >= w ? j - w : 0, b = std::min(m - 1, j + w);
+            const double* sj = src.data() + j * strideI;
+            for (std::size_t i = a; i <= b; i++) {
+                double kij = kernel[w + i - j] / z[j];
+                double* di = data + i * strideI;
+                for (std::size_t r = 0; r < k; r++) di[r] += kij * sj[r];
+            }
+        }
+        return;
+    }
+    src.resize(m);
+    for (std::size_t r = 0; r < k; r++) {
+        double* v = data + r * strideR;
+        for (std::size_t j = 0; j < m; j++) {
+            src[j] = v[j] / z[j];
+            v[j] = 0;
+        }
+        for (std::size_t j = 0; j < m; j++) {
+            if (src[j] == 0) continue;
+            std::size_t a = j >= w ? j - w : 0, b = std::min(m - 1, j + w);
+            const double* kj = kernel.data() + w - j;
+            double sj = src[j];
+            for (std::size_t i = a; i <= b; i++) v[i] += kj[i] * sj;
+        }
+    }
+}
+
+void smoothed_marginal(const std::uint16_t* codes, std::size_t n, const MIGrid& grid, double lambda,
+                       std::vector<double>& out, MIWorkspace& ws) {
+    out.assign(grid.m, 0.0);
+    double total = 0;
+    for (std::size_t i = 0; i < n; i++) {
+        if (codes[i] == MI_MISSING) continue;
+        out[codes[i]] += 1;
+        total += 1;
+    }
+    if (total == 0) return;
+    eilers_solve(out.data(), grid.m, 1, 1, 0, eilers_factor(grid.m, lambda, ws));
+    gauss_smooth(out.data(), grid.m, 1, 1, 0, grid.radius / grid.dx, ws);
+    for (std::size_t i = 0; i < grid.m; i++) out[i] /= total;
+}
+
+double mutualinfo_binned(const std::uint16_t* cx, const MIGrid& gx, const double* px,
+                         const std::uint16_t* cy, const MIGrid& gy, const double* py,
+                         std::size_t n, double lambda, double eps, MIWorkspace& ws) {
+    std::size_t mx = gx.m, my = gy.m;
+
+    // 2d histogram (column-major, x along the rows)
+    std::vector<double>& joint = ws.joint;
+    joint.assign(mx * my, 0.0);
+    double total = 0;
+    for (std::size_t i = 0; i < n; i++) {
+        if (cx[i] == MI_MISSING || cy[i] == MI_MISSING) continue;
+        joint[cx[i] + cy[i] * mx] += 1;
+        total += 1;
+    }
+    if (total == 0) return 0;
+
+    // separable smoothing: first along x (contiguous), then along y
+    eilers_solve(joint.data(), mx, my, 1, mx, eilers_factor(mx, lambda, ws));
+    eilers_solve(joint.data(), my, mx, mx, 1, eilers_factor(my, lambda, ws));
+    gauss_smooth(joint.data(), mx, my, 1, mx, gx.radius / gx.dx, ws);
+    gauss_smooth(joint.data(), my, mx, mx, 1, gy.radius / gy.dx, ws);
+
+    // marginals of the smoothed joint unless they were given
+    std::vector<double>& mpx = ws.px;
+    std::vector<double>& mpy = ws.py;
+    if (!px || !py) {
+        mpx.assign(mx, 0.0);
+        mpy.assign(my, 0.0);
+        for (std::size_t j = 0; j < my; j++)
+            for (std::size_t i = 0; i < mx; i++) {
+                mpx[i] += joint[i + j * mx] / total;
+                mpy[j] += joint[i + j * mx] / total;
+            }
+        px = mpx.data();
+        py = mpy.data();
+    }
+
+    // riemann sum on probability masses; densities below 2 * eps are disregarded
+    double thresh = 2 * eps * gx.dx * gy.dx;
+    double mi = 0;
+    for (std::size_t j = 0; j < my; j++) {
+        if (py[j] <= 0) continue;
+        const double* col = joint.data() + j * mx;
+        for (std::size_t i = 0; i < mx; i++) {
+            double p = col[i] / total;
+            if (p > thresh && px[i] > 0) mi += p * std::log(p / (px[i] * py[j]));
+        }
+    }
+    return mi;
+}
+
+double mutualinfo_continuous(const double* x, const double* y, std::size_t n, std::size_t m,
+                             double lambda, double eps, MIWorkspace& ws) {
+    MIGrid gx = make_grid(x, n, m, ws.sorted);
+    MIGrid gy = make_grid(y, n, m, ws.sorted);
+    if (std::isnan(gx.radius) || std::isnan(gy.radius)) return std::numeric_limits<double>::quiet_NaN();
+
+    ws.cx.resize(n);
+    ws.cy.resize(n);
+    bin_codes(x, n, gx, ws.cx.data());
+    bin_codes(y, n, gy, ws.cy.data());
+    return mutualinfo_binned(ws.cx.data(), gx, nullptr, ws.cy.data(), gy, nullptr, n, lambda, eps, ws);
+}
+
+double mutualinfo_mixed(const double* x, const int* y, std::size_t n, std::size_t ny, std::size_t m,
+                        double lambda, double eps, MIWorkspace& ws) {
+    MIGrid gx = make_grid(x, n, m, ws.sorted);
+    if (std::isnan(gx.radius)) return std::numeric_limits<double>::quiet_NaN();
+
+    ws.cx.resize(n);
+    bin_codes(x, n, gx, ws.cx.data());
+
+    // one histogram of x per level of y
+    std::vector<double>& joint = ws.joint;
+    joint.assign(m * ny, 0.0);
+    std::vector<double>& counts = ws.py;
+    counts.assign(ny, 0.0);
+    double total = 0;
+    for (std::size_t i = 0; i < n; i++) {
+        if (ws.cx[i] == MI_MISSING || y[i] < 0) continue;
+        joint[ws.cx[i] + y[i] * m] += 1;
+        counts[y[i]] += 1;
+        total += 1;
+    }
+    if (total == 0) return 0;
+    eilers_solve(joint.data(), m, ny, 1, m, eilers_factor(m, lambda, ws));
+
+    // marginal of x as the mixture of the conditional densities
+    std::vector<double>& px = ws.px;
+    px.assign(m, 0.0);
+    for (std::size_t k = 0; k < ny; k++)
+        for (std::size_t i = 0; i < m; i++) px[i] += joint[i + k * m] / total;
+
+    double mi = 0;
+    for (std::size_t k = 0; k < ny; k++) {
+        if (counts[k] == 0) continue;
+        const double* col = joint.data() + k * m;
+        for (std::size_t i = 0; i < m; i++) {
+            // conditional density of x given y = k
+            double cond = col[i] / counts[k];
+            if (cond / gx.dx > eps && px[i] > 0) mi += col[i] / total * std::log(cond / px[i]);
+        }
+    }
+    return mi;
+}
+
+std::size_t level_codes(const double* x, std::size_t n, std::vector<double>& levels, int* codes) {
+    levels.clear();
+    for (std::size_t i = 0; i < n; i++) {
+        if (std::isfinite(x[i])) levels.push_back(x[i]);
+    }
+    std::sort(levels.begin(), levels.end());
+    levels.erase(std::unique(levels.begin(), levels.end()), levels.end());
+    for (std::size_t i = 0; i < n; i++) {
+        codes[i] = std::isfinite(x[i]) ? static_cast<int>(std::lower_bound(levels.begin(), levels.end(), x[i]) - levels.begin()) : -1;
+    }
+    return levels.size();
+}
+
+double mutualinfo_counts(const double* joint, std::size_t kx, std::size_t ky, MIWorkspace& ws) {
+    std::vector<double>& ax = ws.px;
+    std::vector<double>& by = ws.py;
+    ax.assign(kx, 0.0);
+    by.assign(ky, 0.0);
+    double total = 0;
+    for (std::size_t j = 0; j < ky; j++)
+        for (std::size_t i = 0; i < kx; i++) {
+            ax[i] += joint[i + j * kx];
+            by[j] += joint[i + j * kx];
+        }
+    for (std::size_t i = 0; i < kx; i++) total += ax[i];
+    if (total <= 0) return 0;
+
+    double mi = 0;
+    for (std::size_t j = 0; j < ky; j++)
+        for (std::size_t i = 0; i < kx; i++) {
+            double count = joint[i + j * kx];
+            if (count > 0) mi += count * std::log(count * total / (ax[i] * by[j]));
+        }
+    return mi / total / std::log(2.0);
+}
+
+double mutualinfo_discrete(const int* x, std::size_t kx, const int* y, std::size_t ky, std::size_t n, MIWorkspace& ws) {
+    double cells = static_cast<double>(kx) * static_cast<double>(ky);
+    if (cells <= std::max(4.0 * n, 65536.0)) {
+        // small tables: count densely and sum over the table
+        std::vector<double>& joint = ws.joint;
+        joint.assign(kx * ky, 0.0);
+        for (std::size_t i = 0; i < n; i++) {
+            if (x[i] < 0 || y[i] < 0) continue;
+            joint[x[i] + y[i] * kx] += 1;
+        }
+        return mutualinfo_counts(joint.data(), kx, ky, ws);
+    }
+
+    // high cardinalities: count runs of equal sorted pair keys instead of a dense table
+    std::vector<double>& ax = ws.px;
+    std::vector<double>& by = ws.py;
+    ax.assign(kx, 0.0);
+    by.assign(ky, 0.0);
+    std::vector<std::uint64_t>& keys = ws.keys;
+    keys.clear();
+    for (std::size_t i = 0; i < n; i++) {
+        if (x[i] < 0 || y[i] < 0) continue;
+        ax[x[i]] += 1;
+        by[y[i]] += 1;
+        keys.push_back(static_cast<std::uint64_t>(x[i]) * ky + static_cast<std::uint64_t>(y[i]));
+    }
+    double total = static_cast<double>(keys.size());
+    if (total == 0) return 0;
+    std::sort(keys.begin(), keys.end());
+
+    // sum over the non-empty cells of c / n * log(c * n / (a * b))
+    double mi = 0;
+    for (std::size_t a = 0; a < keys.size();) {
+        std::size_t b = a;
+        while (b < keys.size() && keys[b] == keys[a]) b++;
+        double count = static_cast<double>(b - a);
+        mi += count * std::log(count * total / (ax[keys[a] / ky] * by[keys[a] % ky]));
+        a = b;
+    }
+    return mi / total / std::log(2.0);
+}
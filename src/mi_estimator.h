@@ -0,0 +1,170 @@
+#pragma once
+
+#include <cstddef> // size_t
+#include <cstdint> // uint16_t
+#include <vector>
+
+/**
+ * Native estimator for the mutual information of continuous (and mixed continuous/discrete) variables.
+ *
+ * The pipeline mirrors the former R implementation of mutualinfo():
+ *   1. Pareto radius of each continuous variable,
+ *   2. an equidistant grid of nbins kernels spanning [min - radius, max + radius],
+ *   3. binning of the observations onto the grid,
+ *   4. Eilers' penalized smoothing of the histogram (lambda),
+ *   5. gaussian smoothing with the Pareto radius as standard deviation,
+ *   6. marginals and the Riemann sum of p * log(p / (px * py)).
+ *
+ * Both smoothing steps are separable and preserve mass, hence the marginals of the smoothed joint are exactly the
+ * smoothed 1d histograms. This allows to bin (and smooth) every variable once and reuse it for many pairs.
+ *
+ * This file does not depend on R so that the heavy lifting can run on worker threads.
+ */
+
+/**
+ * Grid index (code) of observations that are not finite; they are left out pairwise.
+ */
+const std::uint16_t MI_MISSING = 0xFFFF;
+
+/**
+ * The equidistant grid of a continuous variable.
+ */
+struct MIGrid {
+    double lo = 0;      // position of the first grid point
+    double dx = 1;      // distance between two grid points
+    double radius = 0;  // the Pareto radius of the variable
+    std::size_t m = 0;  // number of grid points
+};
+
+/**
+ * Scratch buffers of the estimator. Each thread keeps one instance so that repeated calls do not allocate.
+ */
+struct MIWorkspace {
+    std::vector<double> joint, tmp, line, norm, px, py, sorted, marginal;
+    std::vector<std::uint16_t> cx, cy;
+    std::vector<int> lx, ly;
+    std::vector<std::uint64_t> keys;
+
+    // cached banded cholesky factorization of Eilers' smoothing matrix for (band_m, band_s)
+    std::vector<double> band;
+    std::size_t band_m = 0;
+    double band_s = -1;
+};
+
+/**
+ * Retrieve the workspace of the calling thread.
+ */
+MIWorkspace& mi_workspace();
+
+/**
+ * Pareto radius of a univariate sample, i.e. the 18th percentile of the pairwise distances (scaled down for large n).
+ * At most 10000 equidistantly drawn observations are used.
+ *
+ * @param x           The sample.
+ * @param n           Length of the sample.
+ * @param scratch     Reusable buffer.
+ *
+ * @result  The Pareto radius or NaN if it could not be determined.
+ */
+double pareto_radius(const double* x, std::size_t n, std::vector<double>& scratch);
+
+/**
+ * Build the grid of a continuous variable.
+ *
+ * @param x           The sample.
+ * @param n           Length of the sample.
+ * @param m           Number of grid points.
+ * @param scratch     Reusable buffer.
+ */
+MIGrid make_grid(const double* x, std::size_t n, std::size_t m, std::vector<double>& scratch);
+
+/**
+ * Map every observation onto its nearest grid point; non-finite observations get the code MI_MISSING.
+ *
+ * @param x           The sample.
+ * @param n           Length of the sample.
+ * @param grid        The grid of the sample (see make_grid).
+ * @param codes       Output array of length n.
+ */
+void bin_codes(const double* x, std::size_t n, const MIGrid& grid, std::uint16_t* codes);
+
+/**
+ * Smoothed marginal probability mass of a binned variable on its grid; it sums to 1.
+ *
+ * @param codes       Grid indices of the observations (see bin_codes).
+ * @param n           Number of observations.
+ * @param grid        The grid of the variable.
+ * @param lambda      Smoothing parameter of Eilers' smoother.
+ * @param out         Output vector, resized to grid.m.
+ * @param ws          Workspace of the calling thread.
+ */
+void smoothed_marginal(const std::uint16_t* codes, std::size_t n, const MIGrid& grid, double lambda,
+                       std::vector<double>& out, MIWorkspace& ws);
+
+/**
+ * Mutual information (in nats) of two binned continuous variables.
+ *
+ * @param cx, cy      Grid indices of the observations.
+ * @param gx, gy      The grids of the variables.
+ * @param px, py      The smoothed marginals of the variables (see smoothed_marginal).
+ * @param n           Number of observations.
+ * @param lambda      Smoothing parameter of Eilers' smoother.
+ * @param eps         Densities below 2 * eps are disregarded.
+ * @param ws          Workspace of the calling thread.
+ */
+double mutualinfo_binned(const std::uint16_t* cx, const MIGrid& gx, const double* px,
+                         const std::uint16_t* cy, const MIGrid& gy, const double* py,
+                         std::size_t n, double lambda, double eps, MIWorkspace& ws);
+
+/**
+ * Mutual information (in nats) of two continuous variables.
+ *
+ * @result  The mutual information or NaN if one of the Pareto radii could not be determined.
+ */
+double mutualinfo_continuous(const double* x, const double* y, std::size_t n, std::size_t m,
+                             double lambda, double eps, MIWorkspace& ws);
+
+/**
+ * Mutual information (in nats) of a continuous variable x and a discrete variable y.
+ *
+ * @param x           The continuous sample.
+ * @param y           The level indices (0, ..., ny - 1) of the discrete sample.
+ * @param ny          Number of levels of y.
+ *
+ * @result  The mutual information or NaN if the Pareto radius of x could not be determined.
+ */
+double mutualinfo_mixed(const double* x, const int* y, std::size_t n, std::size_t ny, std::size_t m,
+                        double lambda, double eps, MIWorkspace& ws);
+
+/**
+ * Map the finite values of a discrete sample onto their level indices 0, ..., k - 1 (in increasing order of the values).
+ *
+ * @param x           The sample.
+ * @param n           Length of the sample.
+ * @param levels      Output: the sorted distinct finite values.
+ * @param codes       Output array of length n; non-finite values get -1.
+ *
+ * @result  The number of levels k.
+ */
+std::size_t level_codes(const double* x, std::size_t n, std::vector<double>& levels, int* codes);
+
+/**
+ * Mutual information (in bits) of two discrete samples given by their level indices.
+ * The joint table is counted directly, densely if kx * ky is small compared to n and sparse (sorted pair keys) otherwise;
+ * the sum is done in one pass over the non-empty cells.
+ *
+ * @param x, y        Level indices of the samples, negative indices are left out pairwise.
+ * @param kx, ky      Number of levels of the samples.
+ * @param n           Length of the samples.
+ * @param ws          Workspace of the calling thread.
+ */
+double mutualinfo_discrete(const int* x, std::size_t kx, const int* y, std::size_t ky, std::size_t n, MIWorkspace& ws);
+
+/**
+ * Mutual information (in bits) of a joint table of counts in O(kx * ky).
+ *
+ * @param joint       Column-major kx x ky table of (non-negative) counts.
+ * @param kx, ky      Dimensions of the table.
+ * @param ws          Workspace of the calling thread.
+ */
+double mutualinfo_counts(const double* joint, std::size_t kx, std::size_t ky, MIWorkspace& ws);
@@ -0,0 +1,366 @@
+#include "mi_shared.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "metadata.h"
+#include "mi_estimator.h"
+#include "parallel.h"
+#include "shared_memory.h"
+
+int mutualinfoMatrix(std::string name_space, std::string matName, std::string resultName, std::string codesName,
+                     bool keepCodes, int nbins, double lambda, double eps, int threads, int blockSize) {
+#ifdef _WIN32
+    // For windows we prepend the namespace identifier by "Local\\" because otherwise the shared memory is shared system-wide (instead of user-wide) which needs admin privileges
+    name_space = "Local\\" + name_space;
+#endif
+    if (nbins < 3 || nbins > 65535) stop("nbins has to be between 3 and 65535");
+    if (blockSize < 1) stop("blockSize has to be positive");
+
+    // retrieve the matrix; only drop the view afterwards if this call opened it
+    std::string matPage = name_space + "." + matName;
+    bool hadView = hasView(matPage);
+    auto view = viewPage(matPage, name_space + ".md." + matName);
+    if (view->metaPtr()->data_type != metadata::type::MATRIX) {
+        if (!hadView) releaseView(matPage);
+        stop("Variable '" + matName + "' is not a matrix!");
+    }
+    std::size_t nrow = view->metaPtr()->matrix_data.nrow;
+    std::size_t ncol = view->metaPtr()->matrix_data.ncol;
+    const double* X = view->memPtr();
+
+    std::string codesPage = name_space + "." + codesName;
+    std::string resultPage = name_space + "." + resultName;
+    bool codesRegistered = false, resultRegistered = false;
+    int degenerate = 0;
+    try {
+        // the uint16 codes of a column are packed into ceil(nrow / 4) doubles
+        std::size_t codeRows = (nrow * sizeof(std::uint16_t) + sizeof(double) - 1) / sizeof(double);
+        std::uint16_t* codes = reinterpret_cast<std::uint16_t*>(
+            allocMatrixPage(codesPage, name_space + ".md." + codesName, codeRows, ncol, metadata::CODES));
+        codesRegistered = true;
+        std::size_t codeStride = codeRows * sizeof(double) / sizeof(std::uint16_t);
+
+        double* result = allocMatrixPage(resultPage, name_space + ".md." + resultName, ncol, ncol);
+        resultRegistered = true;
+
+        // bin every column once; columns without missing values also get their smoothed marginal
+        std::vector<MIGrid> grids(ncol);
+        std::vector<std::vector<double>> marginals(ncol);
+        parallel_for(ncol, threads, [&](std::size_t j) {
+            MIWorkspace& ws = mi_workspace();
+            grids[j] = make_grid(X + j * nrow, nrow, nbins, ws.sorted);
+            if (std::isnan(grids[j].radius)) return;
+            std::uint16_t* cj = codes + j * codeStride;
+            bin_codes(X + j * nrow, nrow, grids[j], cj);
+            for (std::size_t i = 0; i < nrow; i++) {
+                if (cj[i] == MI_MISSING) return;
+            }
+            smoothed_marginal(cj, nrow, grids[j], lambda, marginals[j], ws);
+        });
+        for (std::size_t j = 0; j < ncol; j++) {
+            if (std::isnan(grids[j].radius)) degenerate++;
+        }
+
+        // upper triangle in tiles of blockSize x blockSize columns, so that the codes of a tile stay in cache
+        std::size_t nblocks = (ncol + blockSize - 1) / blockSize;
+        std::vector<std::pair<std::size_t, std::size_t>> tiles;
+        for (std::size_t bi = 0; bi < nblocks; bi++)
+            for (std::size_t bj = bi; bj < nblocks; bj++) tiles.push_back({bi, bj});
+
+        parallel_for(tiles.size(), threads, [&](std::size_t t) {
+            MIWorkspace& ws = mi_workspace();
+            std::size_t i0 = tiles[t].first * blockSize, j0 = tiles[t].second * blockSize;
+            std::size_t i1 = std::min(ncol, i0 + blockSize), j1 = std::min(ncol, j0 + blockSize);
+            for (std::size_t j = j0; j < j1; j++) {
+                for (std::size_t i = i0; i < std::min(i1, j); i++) {
+                    double mi = 0;
+                    if (!std::isnan(grids[i].radius) && !std::isnan(grids[j].radius)) {
+                        const double* pi = marginals[i].empty() || marginals[j].empty() ? nullptr : marginals[i].data();
+                        const double* pj = pi ? marginals[j].data() : nullptr;
+                        mi = mutualinfo_binned(codes + i * codeStride, grids[i], pi, codes + j * codeStride, grids[j], pj,
+                                               nrow, lambda, eps, ws);
+                    }
+                    result[i + j * ncol] = mi;
+                    result[j + i * ncol] = mi;
+                }
+            }
+        });
+        for (std::size_t j = 0; j < ncol; j++) result[j + j * ncol] = NA_REAL;
+        completeMatrixPage(codesPage);
+        completeMatrixPage(resultPage);
+    } catch (...) {
+        if (resultRegistered) releasePage(resultPage);
+        if (codesRegistered) releasePage(codesPage);
+        if (!hadView) releaseView(matPage);
+        throw;
+    }
+
+    if (!keepCodes) releasePage(codesPage);
+    if (!hadView) releaseView(matPage);
+    return degenerate;
+}
+
+NumericVector mutualinfoTarget(std::string name_space, std::string matName, NumericVector target, bool targetDiscrete,
+                               int nbins, double lambda, double eps, int threads) {
+#ifdef _WIN32
+    // For windows we prepend the namespace identifier by "Local\\" because otherwise the shared memory is shared system-wide (instead of user-wide) which needs admin privileges
+    name_space = "Local\\" + name_space;
+#endif
+    if (nbins < 3 || nbins > 65535) stop("nbins has to be between 3 and 65535");
+
+    std::string matPage = name_space + "." + matName;
+    bool hadView = hasView(matPage);
+    auto view = viewPage(matPage, name_space + ".md." + matName);
+    if (view->metaPtr()->data_type != metadata::type::MATRIX) {
+        if (!hadView) releaseView(matPage);
+        stop("Variable '" + matName + "' is not a matrix!");
+    }
+    std::size_t nrow = view->metaPtr()->matrix_data.nrow;
+    std::size_t ncol = view->metaPtr()->matrix_data.ncol;
+    const double* X = view->memPtr();
+    if (static_cast<std::size_t>(target.size()) != nrow) {
+        if (!hadView) releaseView(matPage);
+        stop("The target has to have as many elements as the matrix has rows!");
+    }
+
+    NumericVector result(ncol);
+    double* res = result.begin();
+    try {
+        // everything about the target is computed once
+        MIWorkspace& ws = mi_workspace();
+        std::vector<int> tlevels;
+        std::vector<std::uint16_t> tcodes;
+        std::vector<double> tmarginal, levelValues;
+        MIGrid tgrid;
+        std::size_t nlevels = 0;
+        bool targetComplete = true;
+        if (targetDiscrete) {
+            tlevels.resize(nrow);
+            nlevels = level_codes(target.begin(), nrow, levelValues, tlevels.data());
+        } else {
+            tgrid = make_grid(target.begin(), nrow, nbins, ws.sorted);
+            if (std::isnan(tgrid.radius)) stop("The Pareto radius of the target could not be determined!");
+            tcodes.resize(nrow);
+            bin_codes(target.begin(), nrow, tgrid, tcodes.data());
+            targetComplete = std::find(tcodes.begin(), tcodes.end(), MI_MISSING) == tcodes.end();
+            if (targetComplete) smoothed_marginal(tcodes.data(), nrow, tgrid, lambda, tmarginal, ws);
+        }
+
+        parallel_for(ncol, threads, [&](std::size_t j) {
+            MIWorkspace& tws = mi_workspace();
+            const double* xj = X + j * nrow;
+            if (targetDiscrete) {
+                res[j] = mutualinfo_mixed(xj, tlevels.data(), nrow, nlevels, nbins, lambda, eps, tws);
+                return;
+            }
+            MIGrid grid = make_grid(xj, nrow, nbins, tws.sorted);
+            if (std::isnan(grid.radius)) {
+                res[j] = std::numeric_limits<double>::quiet_NaN();
+                return;
+            }
+            tws.cx.resize(nrow);
+            bin_codes(xj, nrow, grid, tws.cx.data());
+            bool complete = targetComplete && std::find(tws.cx.begin(), tws.cx.end(), MI_MISSING) == tws.cx.end();
+            if (complete) smoothed_marginal(tws.cx.data(), nrow, grid, lambda, tws.marginal, tws);
+            res[j] = mutualinfo_binned(tws.cx.data(), grid, complete ? tws.marginal.data() : nullptr,
+                                       tcodes.data(), tgrid, complete ? tmarginal.data() : nullptr,
+                                       nrow, lambda, eps, tws);
+        }, 4);
+    } catch (...) {
+        if (!hadView) releaseView(matPage);
+        throw;
+    }
+    if (!hadView) releaseView(matPage);
+    return result;
+}
+
+/**
+ * The elements of a streaming estimator page.
+ */
+struct StreamLayout {
+    double* counts;
+    std::size_t kx, ky;
+    const double* xbreaks;
+    const double* ybreaks;
+};
+
+// locate the elements of the list page of a streaming estimator and check its shape
+static StreamLayout stream_layout(SharedData* data, const std::string& name) {
+    metadata* m = data->metaPtr();
+    if (m[0].data_type != metadata::type::LIST || m[0].list_data.n != 3 || m[1].data_type != metadata::type::MATRIX ||
+        m[2].data_type != metadata::type::VECTOR || m[3].data_type != metadata::type::VECTOR ||
+        m[2].vector_data.n != m[1].matrix_data.nrow + 1 || m[3].vector_data.n != m[1].matrix_data.ncol + 1) {
+        stop("Variable '" + name + "' is not a streaming mutual information estimator!");
+    }
+    // a list page starts with the offsets of its elements followed by their data
+    unsigned long long* offsets = static_cast<unsigned long long*>(static_cast<void*>(data->memPtr()));
+    double* start = data->memPtr() + m[0].list_data.n;
+
+    StreamLayout layout;
+    layout.counts = start + offsets[0];
+    layout.kx = m[1].matrix_data.nrow;
+    layout.ky = m[1].matrix_data.ncol;
+    layout.xbreaks = start + offsets[1];
+    layout.ybreaks = start + offsets[2];
+    return layout;
+}
+
+// the bin of v given nb breaks; values outside the breaks are clamped to the outer bins, non-finite values give -1
+static long stream_bin(const double* breaks, std::size_t nb, double v) {
+    if (!std::isfinite(v)) return -1;
+    long bin = static_cast<long>(std::upper_bound(breaks, breaks + nb, v) - breaks) - 1;
+    return std::min(std::max(bin, 0L), static_cast<long>(nb) - 2);
+}
+
+// add the counts of a batch to a kx x ky table
+static void stream_count(const StreamLayout& layout, NumericVector x, NumericVector y, double* counts) {
+    if (x.size() != y.size()) stop("x and y have to be of the same length");
+    for (R_xlen_t i = 0; i < x.size(); i++) {
+        long bx = stream_bin(layout.xbreaks, layout.kx + 1, x[i]);
+        long by = stream_bin(layout.ybreaks, layout.ky + 1, y[i]);
+        if (bx < 0 || by < 0) continue;
+        counts[bx + by * layout.kx] += 1;
+    }
+}
+
+// the page of an estimator owned by this process
+static SharedData* owned_stream(std::string& name_space, const std::string& name) {
+#ifdef _WIN32
+    // For windows we prepend the namespace identifier by "Local\\" because otherwise the shared memory is shared system-wide (instead of user-wide) which needs admin privileges
+    name_space = "Local\\" + name_space;
+#endif
+    auto it = pages.find(name_space + "." + name);
+    if (it == pages.end()) {
+        stop("Streaming estimator " + name + " can only be updated by the process that registered it!");
+    }
+    return it->second.get();
+}
+
+void mutualinfoStreamUpdate(std::string name_space, std::string name, NumericVector x, NumericVector y) {
+    StreamLayout layout = stream_layout(owned_stream(name_space, name), name);
+    stream_count(layout, x, y, layout.counts);
+}
+
+void mutualinfoStreamMerge(std::string name_space, std::string name, NumericMatrix partial) {
+    StreamLayout layout = stream_layout(owned_stream(name_space, name), name);
+    if (static_cast<std::size_t>(partial.nrow()) != layout.kx || static_cast<std::size_t>(partial.ncol()) != layout.ky) {
+        stop("The partial table of counts does not match the dimensions of estimator " + name + "!");
+    }
+    const double* p = partial.begin();
+    for (std::size_t i = 0; i < layout.kx * layout.ky; i++) layout.counts[i] += p[i];
+}
+
+NumericMatrix mutualinfoStreamCounts(std::string name_space, std::string name, NumericVector x, NumericVector y) {
+#ifdef _WIN32
+    // For windows we prepend the namespace identifier by "Local\\" because otherwise the shared memory is shared system-wide (instead of user-wide) which needs admin privileges
+    name_space = "Local\\" + name_space;
+#endif
+    std::string page = name_space + "." + name;
+    bool hadView = hasView(page);
+    auto view = viewPage(page, name_space + ".md." + name);
+    try {
+        StreamLayout layout = stream_layout(view.get(), name);
+        NumericMatrix counts(layout.kx, layout.ky);
+        stream_count(layout, x, y, counts.begin());
+        if (!hadView) releaseView(page);
+        return counts;
+    } catch (...) {
+        if (!hadView) releaseView(page);
+        throw;
+    }
+}
+
+double mutualinfoStreamValue(std::string name_space, std::string name) {
+#ifdef _WIN32
+    // For windows we prepend the namespace identifier by "Local\\" because otherwise the shared memory is shared system-wide (instead of user-wide) which needs admin privileges
+    name_space = "Local\\" + name_space;
+#endif
+    std::string page = name_space + "." + name;
+    bool hadView = hasView(page);
+    auto view = viewPage(page, name_space + ".md." + name);
+    try {
+        StreamLayout layout = stream_layout(view.get(), name);
+        double mi = mutualinfo_counts(layout.counts, layout.kx, layout.ky, mi_workspace());
+        if (!hadView) releaseView(page);
+        return mi;
+    } catch (...) {
+        if (!hadView) releaseView(page);
+        throw;
+    }
+}
+
+extern "C" SEXP C_mutualinfoMatrix(SEXP name_spaceSEXP, SEXP matNameSEXP, SEXP resultNameSEXP, SEXP codesNameSEXP,
+                                   SEXP keepCodesSEXP, SEXP nbinsSEXP, SEXP lambdaSEXP, SEXP epsSEXP,
+                                   SEXP threadsSEXP, SEXP blockSizeSEXP) {
+    try {
+        int res = mutualinfoMatrix(as<std::string>(name_spaceSEXP), as<std::string>(matNameSEXP),
+                                   as<std::string>(resultNameSEXP), as<std::string>(codesNameSEXP),
+                                   as<bool>(keepCodesSEXP), as<int>(nbinsSEXP), as<double>(lambdaSEXP),
+                                   as<double>(epsSEXP), as<int>(threadsSEXP), as<int>(blockSizeSEXP));
+        return wrap(res);
+    } catch (std::exception &e) {
+        Rf_error("mutualinfoMatrix error: %s", e.what());
+    } catch (...) {
+        Rf_error("mutualinfoMatrix unknown error");
+    }
+}
+
+extern "C" SEXP C_mutualinfoTarget(SEXP name_spaceSEXP, SEXP matNameSEXP, SEXP targetSEXP, SEXP targetDiscreteSEXP,
+                                   SEXP nbinsSEXP, SEXP lambdaSEXP, SEXP epsSEXP, SEXP threadsSEXP) {
+    try {
+        NumericVector res = mutualinfoTarget(as<std::string>(name_spaceSEXP), as<std::string>(matNameSEXP),
+                                             NumericVector(targetSEXP), as<bool>(targetDiscreteSEXP),
+                                             as<int>(nbinsSEXP), as<double>(lambdaSEXP), as<double>(epsSEXP),
+                                             as<int>(threadsSEXP));
+        return res;
+    } catch (std::exception &e) {
+        Rf_error("mutualinfoTarget error: %s", e.what());
+    } catch (...) {
+        Rf_error("mutualinfoTarget unknown error");
+    }
+}
+
+extern "C" SEXP C_mutualinfoStreamUpdate(SEXP name_spaceSEXP, SEXP nameSEXP, SEXP xSEXP, SEXP ySEXP) {
+    try {
+        mutualinfoStreamUpdate(as<std::string>(name_spaceSEXP), as<std::string>(nameSEXP), NumericVector(xSEXP), NumericVector(ySEXP));
+        return R_NilValue; // function returns void
+    } catch (std::exception &e) {
+        Rf_error("mutualinfoStreamUpdate error: %s", e.what());
+    } catch (...) {
+        Rf_error("mutualinfoStreamUpdate unknown error");
+    }
+}
+extern "C" SEXP C_mutualinfoStreamMerge(SEXP name_spaceSEXP, SEXP nameSEXP, SEXP partialSEXP) {
+    try {
+        mutualinfoStreamMerge(as<std::string>(name_spaceSEXP), as<std::string>(nameSEXP), NumericMatrix(partialSEXP));
+        return R_NilValue; // function returns void
+    } catch (std::exception &e) {
+        Rf_error("mutualinfoStreamMerge error: %s", e.what());
+    } catch (...) {
+        Rf_error("mutualinfoStreamMerge unknown error");
+    }
+}
+extern "C" SEXP C_mutualinfoStreamCounts(SEXP name_spaceSEXP, SEXP nameSEXP, SEXP xSEXP, SEXP ySEXP) {
+    try {
+        NumericMatrix res = mutualinfoStreamCounts(as<std::string>(name_spaceSEXP), as<std::string>(nameSEXP), NumericVector(xSEXP), NumericVector(ySEXP));
+        return res;
+    } catch (std::exception &e) {
+        Rf_error("mutualinfoStreamCounts error: %s", e.what());
+    } catch (...) {
+        Rf_error("mutualinfoStreamCounts unknown error");
+    }
+}
+extern "C" SEXP C_mutualinfoStreamValue(SEXP name_spaceSEXP, SEXP nameSEXP) {
+    try {
+        double res = mutualinfoStreamValue(as<std::string>(name_spaceSEXP), as<std::string>(nameSEXP));
+        return wrap(res);
+    } catch (std::exception &e) {
+        Rf_error("mutualinfoStreamValue error: %s", e.what());
+    } catch (...) {
+        Rf_error("mutualinfoStreamValue unknown error");
+    }
+}
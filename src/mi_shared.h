@@ -0,0 +1,105 @@
+#pragma once
+#include <Rcpp.h>
+
+using namespace Rcpp;
+
+/**
+ * Computes the mutual information of every pair of columns of a shared matrix into a shared result matrix.
+ * Every column is binned once (the grid codes are stored in a shared page as well); then the upper triangle
+ * is computed in cache-blocked tiles of columns on a thread pool and mirrored into the lower triangle.
+ * 
+ * @param name_space        A string identifying the memory space we are working in.
+ * @param matName           The name of the shared double matrix inside the memory space.
+ * @param resultName        The name under which the ncol x ncol result matrix gets registered.
+ * @param codesName         The name under which the grid codes of the columns get registered.
+ * @param keepCodes         Whether the codes page stays registered after the computation.
+ * @param nbins             Number of grid points per column.
+ * @param lambda            Smoothing parameter of the histogram smoothing.
+ * @param eps               Densities below 2 * eps are disregarded.
+ * @param threads           Number of threads (0 = all available).
+ * @param blockSize         Number of columns per tile side.
+ * 
+ * @result  The number of columns whose Pareto radius could not be determined (their mutual information is 0).
+ */
+int mutualinfoMatrix(std::string name_space, std::string matName, std::string resultName, std::string codesName,
+                     bool keepCodes, int nbins, double lambda, double eps, int threads, int blockSize);
+
+/**
+ * Computes the mutual information between one target vector and every column of a shared matrix.
+ * The target is binned (continuous) or level coded (discrete) once and its smoothed marginal is reused for every column;
+ * the columns are streamed on a thread pool without any R-level per-column calls.
+ * 
+ * @param name_space        A string identifying the memory space we are working in.
+ * @param matName           The name of the shared double matrix inside the memory space.
+ * @param target            The target vector of length nrow.
+ * @param targetDiscrete    Whether the target is discrete (class labels) or continuous.
+ * @param nbins             Number of grid points per continuous variable.
+ * @param lambda            Smoothing parameter of the histogram smoothing.
+ * @param eps               Densities below 2 * eps are disregarded.
+ * @param threads           Number of threads (0 = all available).
+ * 
+ * @result  Vector of length ncol with the mutual information of the target and each column; columns whose Pareto radius
+ *          could not be determined get NaN.
+ */
+NumericVector mutualinfoTarget(std::string name_space, std::string matName, NumericVector target, bool targetDiscrete,
+                               int nbins, double lambda, double eps, int threads);
+
+/**
+ * Streaming mutual information estimators are registered lists of three elements: the kx x ky joint table of counts
+ * and the kx + 1 breaks of x and ky + 1 breaks of y. Values outside the breaks fall into the first or last bin,
+ * non-finite values are left out pairwise.
+ */
+
+/**
+ * Adds a batch of observations to the counts of a streaming estimator in place. Only the owner of the page can update it.
+ * 
+ * @param name_space        A string identifying the memory space we are working in.
+ * @param name              The name of the registered estimator.
+ * @param x, y              The new observations.
+ */
+void mutualinfoStreamUpdate(std::string name_space, std::string name, NumericVector x, NumericVector y);
+
+/**
+ * Adds a partial table of counts (e.g. computed by a worker via mutualinfoStreamCounts) to a streaming estimator in place.
+ * 
+ * @param partial           kx x ky table of counts.
+ */
+void mutualinfoStreamMerge(std::string name_space, std::string name, NumericMatrix partial);
+
+/**
+ * Counts a batch of observations with the breaks of a streaming estimator without modifying it; works in any process.
+ * 
+ * @result  kx x ky table of counts of the batch.
+ */
+NumericMatrix mutualinfoStreamCounts(std::string name_space, std::string name, NumericVector x, NumericVector y);
+
+/**
+ * Current mutual information (in bits) of a streaming estimator in O(kx * ky).
+ */
+double mutualinfoStreamValue(std::string name_space, std::string name);
+
+
+
+
+/**
+ * Wrapper function for mutualinfoMatrix above.
+ * 
+ * @result  The number of degenerate columns as an R integer.
+ */
+extern "C" SEXP C_mutualinfoMatrix(SEXP name_spaceSEXP, SEXP matNameSEXP, SEXP resultNameSEXP, SEXP codesNameSEXP,
+                                   SEXP keepCodesSEXP, SEXP nbinsSEXP, SEXP lambdaSEXP, SEXP epsSEXP,
+                                   SEXP threadsSEXP, SEXP blockSizeSEXP);
+
+/**
+ * Wrapper function for mutualinfoTarget above.
+ */
+extern "C" SEXP C_mutualinfoTarget(SEXP name_spaceSEXP, SEXP matNameSEXP, SEXP targetSEXP, SEXP targetDiscreteSEXP,
+                                   SEXP nbinsSEXP, SEXP lambdaSEXP, SEXP epsSEXP, SEXP threadsSEXP);
+
+/**
+ * Wrapper functions for the streaming estimator functions above.
+ */
+extern "C" SEXP C_mutualinfoStreamUpdate(SEXP name_spaceSEXP, SEXP nameSEXP, SEXP xSEXP, SEXP ySEXP);
+extern "C" SEXP C_mutualinfoStreamMerge(SEXP name_spaceSEXP, SEXP nameSEXP, SEXP partialSEXP);
+extern "C" SEXP C_mutualinfoStreamCounts(SEXP name_spaceSEXP, SEXP nameSEXP, SEXP xSEXP, SEXP ySEXP);
+extern "C" SEXP C_mutualinfoStreamValue(SEXP name_spaceSEXP, SEXP nameSEXP);
@@ -0,0 +1,128 @@
+#include "numa.h"
+
+#include <cstdlib>
+#include <stdexcept>
+#include <vector>
+
+#ifdef __linux__
+#include <fstream>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+numa_placement numa_parse_placement(const std::string& name) {
+    if (name == "default") return NUMA_DEFAULT;
+    if (name == "interleave") return NUMA_INTERLEAVE;
+    if (name == "blocks") return NUMA_BLOCKS;
+    throw std::runtime_error("Unknown placement '" + name + "', use 'default', 'interleave' or 'blocks'!");
+}
+
+#ifdef __linux__
+namespace {
+
+// the policies of <numaif.h>, which is part of libnuma
+const int MPOL_PREFERRED_MODE = 1;
+const int MPOL_INTERLEAVE_MODE = 3;
+const unsigned MPOL_MF_MOVE_FLAG = 1u << 1;
+const std::size_t MASK_WORDS = 16; // 1024 nodes
+const std::size_t WORD_BITS = 8 * sizeof(unsigned long);
+
+// a list of the kernel like "0-3,8,10-11"
+std::vector<int> read_list(const std::string& path) {
+    std::vector<int> ids;
+    std::ifstream file(path);
+    std::string list;
+    if (!std::getline(file, list)) return ids;
+    std::size_t pos = 0;
+    while (pos < list.size()) {
+        std::size_t end = list.find(',', pos);
+        if (end == std::string::npos) end = list.size();
+        std::string range = list.substr(pos, end - pos);
+        pos = end + 1;
+        if (range.empty()) continue;
+        std::size_t dash = range.find('-');
+        int first = std::atoi(range.c_str());
+        int last = dash == std::string::npos ? first : std::atoi(range.c_str() + dash + 1);
+        for (int i = first; i <= last; i++) ids.push_back(i);
+    }
+    return ids;
+}
+
+const std::vector<int>& online_nodes() {
+    static const std::vector<int> nodes = read_list("/sys/devices/system/node/online");
+    return nodes;
+}
+
+bool mbind_range(void* addr, std::size_t bytes, int mode, const std::vector<int>& nodes) {
+    unsigned long mask[MASK_WORDS] = {0};
+    for (int node : nodes) {
+        if (node < 0 || static_cast<std::size_t>(node) >= MASK_WORDS * WORD_BITS) return false;
+        mask[node / WORD_BITS] |= 1UL << (node % WORD_BITS);
+    }
+    // the kernel reads maxnode - 1 bits of the mask
+    return syscall(SYS_mbind, addr, bytes, mode, mask, MASK_WORDS * WORD_BITS + 1, MPOL_MF_MOVE_FLAG) == 0;
+}
+
+}
+#endif
+
+int numa_node_count() {
+#ifdef __linux__
+    return online_nodes().empty() ? 1 : static_cast<int>(online_nodes().size());
+#else
+    return 1;
+#endif
+}
+
+bool numa_place(void* addr, std::size_t bytes, numa_placement placement) {
+#ifdef __linux__
+    const std::vector<int>& nodes = online_nodes();
+    if (placement == NUMA_DEFAULT || nodes.size() < 2 || bytes == 0) return false;
+    if (placement == NUMA_INTERLEAVE) return mbind_range(addr, bytes, MPOL_INTERLEAVE_MODE, nodes);
+
+    // one block per node, the boundaries rounded to pages
+    std::size_t page = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+    std::size_t n = nodes.size();
+    bool placed = true;
+    for (std::size_t i = 0; i < n; i++) {
+        std::size_t begin = bytes / n * i / page * page;
+        std::size_t end = i + 1 == n ? bytes : bytes / n * (i + 1) / page * page;
+        if (end <= begin) continue;
+        placed = mbind_range(static_cast<char*>(addr) + begin, end - begin, MPOL_PREFERRED_MODE, {nodes[i]}) && placed;
+    }
+    return placed;
+#else
+    (void) addr;
+    (void) bytes;
+    (void) placement;
+    return false;
+#endif
+}
+
+int numa_worker_node(int worker, int workers) {
+    int n = numa_node_count();
+    if (workers <= 0 || worker < 0 || worker >= workers) return 0;
+    return static_cast<int>(static_cast<long long>(worker) * n / workers);
+}
+
+int numa_pin_worker(int worker, int workers) {
+#ifdef __linux__
+    const std::vector<int>& nodes = online_nodes();
+    if (nodes.size() < 2) return -1;
+    int node = nodes[numa_worker_node(worker, workers)];
+    std::vector<int> cpus = read_list("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+    if (cpus.empty()) return -1;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : cpus) {
+        if (cpu >= 0 && cpu < CPU_SETSIZE) CPU_SET(cpu, &set);
+    }
+    if (sched_setaffinity(0, sizeof(set), &set) != 0) return -1;
+    return node;
+#else
+    (void) worker;
+    (void) workers;
+    return -1;
+#endif
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstddef> // size_t
+#include <string>
+
+/**
+ * NUMA placement of data pages and CPU affinity of worker processes. On a machine with several memory nodes (sockets),
+ * every page of a fresh data page lands on the node of the thread touching it first, i.e. the copy of the owner puts
+ * a whole variable next to one socket and the workers on the other sockets read it remotely.
+ *
+ * A placement policy is set on the range of a data page before it is written; pages that are present already are
+ * migrated. The policies are set via the mbind and sched_setaffinity system calls directly (no libnuma); on machines
+ * with a single node and where they are not available (Windows, macOS) every function here is a no-op.
+ *
+ * This file does not depend on R.
+ */
+
+enum numa_placement : int {
+    NUMA_DEFAULT = 0,       // first touch, i.e. the node of the copying thread
+    NUMA_INTERLEAVE = 1,    // pages round-robin over all nodes
+    NUMA_BLOCKS = 2         // the range split into one contiguous block per node, in the order of the nodes
+};
+
+/**
+ * Parses the name of a policy ("default", "interleave" or "blocks"); throws std::runtime_error for any other.
+ */
+numa_placement numa_parse_placement(const std::string& name);
+
+/**
+ * The number of memory nodes of the machine; 1 where it cannot be told.
+ */
+int numa_node_count();
+
+/**
+ * Sets the placement policy of a mapped range; a no-op for NUMA_DEFAULT and on a single node.
+ *
+ * @param addr        Start of the range, aligned to a page.
+ * @param bytes       Length of the range.
+ *
+ * @result  Whether a policy was set.
+ */
+bool numa_place(void* addr, std::size_t bytes, numa_placement placement);
+
+/**
+ * The position (among the nodes) of the node of a worker if the workers 0, ..., workers - 1 are spread over the nodes
+ * in contiguous groups, which matches the blocks of NUMA_BLOCKS when worker w processes the w-th of workers equal parts
+ * of a variable.
+ */
+int numa_worker_node(int worker, int workers);
+
+/**
+ * Restricts the calling process to the CPUs of its node as a worker (see numa_worker_node).
+ *
+ * @result  The node or -1 if the process was not pinned (single node or not supported).
+ */
+int numa_pin_worker(int worker, int workers);
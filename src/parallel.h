@@ -0,0 +1,142 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef> // size_t
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+/**
+ * Number of threads to use if the caller did not specify one.
+ */
+inline std::size_t default_threads() {
+    unsigned int n = std::thread::hardware_concurrency();
+    return n == 0 ? 1 : n;
+}
+
+/**
+ * Runs body(i) for every i in [0, n) on a pool of up to nthreads threads.
+ * Work is handed out dynamically in chunks of grain indices, so uneven tasks balance out.
+ * The first exception thrown by any body is rethrown in the calling thread after all threads joined.
+ *
+ * @note    The body must never call into R (no Rcpp objects, no R_alloc, no Rprintf, ...).
+ *
+ * @param n           Number of tasks.
+ * @param nthreads    Maximum number of threads (0 = default_threads()).
+ * @param body        Callable taking the task index.
+ * @param grain       Number of consecutive tasks a thread takes at once.
+ */
+template <class F>
+void parallel_for(std::size_t n, std::size_t nthreads, F body, std::size_t grain = 1) {
+    if (n == 0) return;
+    if (nthreads == 0) nthreads = default_threads();
+    grain = std::max<std::size_t>(grain, 1);
+    nthreads = std::min(nthreads, (n + grain - 1) / grain);
+
+    std::atomic<std::size_t> next(0);
+    std::exception_ptr error = nullptr;
+    std::mutex errorMutex;
+
+    auto worker = [&]() {
+        try {
+            for (;;) {
+                std::size_t start = next.fetch_add(grain);
+                if (start >= n) break;
+                std::size_t end = std::min(n, start + grain);
+                for (std::size_t i = start; i < end; i++) body(i);
+            }
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(errorMutex);
+            if (!error) error = std::current_exception();
+            next.store(n);
+        }
+    };
+
+    if (nthreads <= 1) {
+        worker();
+    } else {
+        std::vector<std::thread> pool;
+        pool.reserve(nthreads - 1);
+        for (std::size_t t = 0; t + 1 < nthreads; t++) pool.emplace_back(worker);
+        // the calling thread works as well
+        worker();
+        for (auto& th : pool) th.join();
+    }
+    if (error) std::rethrow_exception(error);
+}
+
+// copies below this size are done by a single memcpy; threads do not pay off for them
+const std::size_t PARALLEL_COPY_MIN_BYTES = std::size_t(32) << 20;
+// bytes a thread copies at once
+const std::size_t PARALLEL_COPY_CHUNK_BYTES = std::size_t(4) << 20;
+// copies of at least this size bypass the caches (non-temporal stores), as the data would only evict everything else
+const std::size_t STREAMING_COPY_MIN_BYTES = std::size_t(256) << 20;
+
+/**
+ * memcpy with non-temporal stores where available (SSE2); falls back to std::memcpy.
+ */
+inline void streaming_copy(void* dest, const void* src, std::size_t bytes) {
+#if defined(__SSE2__) || defined(_M_X64)
+    char* d = static_cast<char*>(dest);
+    const char* s = static_cast<const char*>(src);
+    // align the destination to 16 bytes for the streaming stores
+    std::size_t head = (16 - reinterpret_cast<std::uintptr_t>(d) % 16) % 16;
+    if (head > bytes) head = bytes;
+    std::memcpy(d, s, head);
+    d += head;
+    s += head;
+    bytes -= head;
+    std::size_t blocks = bytes / 64;
+    for (std::size_t i = 0; i < blocks; i++, d += 64, s += 64) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + 16));
+        __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + 32));
+        __m128i e = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + 48));
+        _mm_stream_si128(reinterpret_cast<__m128i*>(d), a);
+        _mm_stream_si128(reinterpret_cast<__m128i*>(d + 16), b);
+        _mm_stream_si128(reinterpret_cast<__m128i*>(d + 32), c);
+        _mm_stream_si128(reinterpret_cast<__m128i*>(d + 48), e);
+    }
+    std::memcpy(d, s, bytes % 64);
+    // make the streamed data visible before the copy is reported as done
+    _mm_sfence();
+#else
+    std::memcpy(dest, src, bytes);
+#endif
+}
+
+/**
+ * Copies bytes from src to dest in chunks on up to nthreads threads. Besides the bandwidth of several cores this
+ * spreads the page faults of a freshly mapped destination over the threads.
+ *
+ * @param nthreads    Maximum number of threads (0 = default_threads()).
+ */
+inline void parallel_copy(void* dest, const void* src, std::size_t bytes, std::size_t nthreads) {
+    bool streaming = bytes >= STREAMING_COPY_MIN_BYTES;
+    if (bytes < PARALLEL_COPY_MIN_BYTES || nthreads == 1) {
+        if (streaming) {
+            streaming_copy(dest, src, bytes);
+        } else {
+            std::memcpy(dest, src, bytes);
+        }
+        return;
+    }
+    std::size_t nchunks = (bytes + PARALLEL_COPY_CHUNK_BYTES - 1) / PARALLEL_COPY_CHUNK_BYTES;
+    parallel_for(nchunks, nthreads, [&](std::size_t c) {
+        std::size_t begin = c * PARALLEL_COPY_CHUNK_BYTES;
+        std::size_t len = std::min(PARALLEL_COPY_CHUNK_BYTES, bytes - begin);
+        if (streaming) {
+            streaming_copy(static_cast<char*>(dest) + begin, static_cast<const char*>(src) + begin, len);
+        } else {
+            std::memcpy(static_cast<char*>(dest) + begin, static_cast<const char*>(src) + begin, len);
+        }
+    });
+}
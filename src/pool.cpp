@@ -0,0 +1,132 @@
+#include "pool.h"
+#include "reclaim.h"
+
+#include <map>
+#include <mutex>
+#include <stdexcept>
+
+namespace {
+
+#ifdef _WIN32
+const std::string POOL_PREFIX = "Local\\memshare.pool.";
+#else
+const std::string POOL_PREFIX = "memshare.pool.";
+#endif
+
+// set when the pool is destroyed at exit; owners released afterwards (in static destructors) remove their pages
+bool closed = false;
+
+// the pooled pages by size; they are removed with the pool
+struct Pool : std::multimap<std::size_t, std::unique_ptr<MemoryPage>> {
+    ~Pool() { closed = true; }
+} pooled;
+std::uint64_t limit = POOL_DEFAULT_LIMIT;
+std::uint64_t pooledBytes = 0;
+std::uint64_t hits = 0, misses = 0;
+std::uint64_t nextPage = 0;
+std::mutex poolMutex;
+
+std::size_t page_bytes(const MemoryPage& page) {
+    return page.size() * sizeof(double);
+}
+
+// remove the largest pooled pages until the pool fits its limit; the caller holds poolMutex
+void trim() {
+    while (pooledBytes > limit && !pooled.empty()) {
+        auto last = std::prev(pooled.end());
+        pooledBytes -= last->first;
+        pooled.erase(last);
+    }
+}
+
+}
+
+std::size_t pool_size_class(std::size_t bytes) {
+    std::size_t page = MemoryPage::granularity();
+    std::size_t size = (bytes + page - 1) / page * page;
+    if (size <= 4 * page) return size == 0 ? page : size;
+    std::size_t base = 4 * page;
+    while (base * 2 < size) base *= 2;
+    std::size_t step = base / 4;
+    return (size + step - 1) / step * step;
+}
+
+std::unique_ptr<MemoryPage> pool_take(std::size_t bytes, bool populate, bool& reused) {
+    std::size_t size = pool_size_class(bytes);
+    std::uint64_t n;
+    {
+        reused = false;
+        if (closed) return nullptr;
+        std::lock_guard<std::mutex> lock(poolMutex);
+        if (size > limit) return nullptr;
+        auto it = pooled.find(size);
+        if (it != pooled.end()) {
+            std::unique_ptr<MemoryPage> page = std::move(it->second);
+            pooled.erase(it);
+            pooledBytes -= size;
+            hits++;
+            reused = true;
+            return page;
+        }
+        misses++;
+        n = nextPage;
+        nextPage += 16;
+    }
+
+    // the start time tells this process from an earlier one with the same id, whose pages might still be there
+    static const std::string prefix = POOL_PREFIX + std::to_string(current_pid()) + "." +
+                                      std::to_string(process_start_time(current_pid())) + ".";
+    for (std::uint64_t k = 0; ; k++) {
+        auto page = std::make_unique<MemoryPage>();
+        try {
+            page->alloc(prefix + std::to_string(n + k), size, populate);
+            return page;
+        } catch (std::runtime_error&) {
+            if (k + 1 == 16) throw;
+        }
+    }
+}
+
+bool pool_give(std::unique_ptr<MemoryPage>& page) {
+    if (closed) return false;
+    std::size_t size = page_bytes(*page);
+    if (page->get_name().compare(0, POOL_PREFIX.size(), POOL_PREFIX) != 0 || pool_size_class(size) != size) return false;
+    std::lock_guard<std::mutex> lock(poolMutex);
+    if (pooledBytes + size > limit) return false;
+    pooled.emplace(size, std::move(page));
+    pooledBytes += size;
+    return true;
+}
+
+void pool_set_limit(std::uint64_t bytes) {
+    std::lock_guard<std::mutex> lock(poolMutex);
+    limit = bytes;
+    trim();
+}
+
+PoolStats pool_stats() {
+    std::lock_guard<std::mutex> lock(poolMutex);
+    return {limit, pooledBytes, static_cast<std::uint64_t>(pooled.size()), hits, misses};
+}
+
+bool pool_page_owner(const std::string& name, std::int64_t& pid, std::uint64_t& start) {
+    if (name.compare(0, POOL_PREFIX.size(), POOL_PREFIX) != 0) return false;
+    // the fields <pid>.<start>.<n>
+    std::uint64_t fields[3] = {0, 0, 0};
+    std::size_t field = 0, digits = 0;
+    for (std::size_t k = POOL_PREFIX.size(); k < name.size(); k++) {
+        if (name[k] == '.') {
+            if (digits == 0 || ++field == 3) return false;
+            digits = 0;
+        } else if (name[k] >= '0' && name[k] <= '9') {
+            fields[field] = fields[field] * 10 + static_cast<std::uint64_t>(name[k] - '0');
+            digits++;
+        } else {
+            return false;
+        }
+    }
+    if (field != 2 || digits == 0) return false;
+    pid = static_cast<std::int64_t>(fields[0]);
+    start = fields[1];
+    return true;
+}
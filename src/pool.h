@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstddef> // size_t
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "memory_page.h"
+
+/**
+ * A pool of data pages owned by this process. Registering and releasing a variable costs the creation, sizing,
+ * mapping and first touch of its data page and the unmapping and removal afterwards; for short-lived variables (e.g.
+ * the matrices memApply registers on every call) this dominates. Instead, released data pages of up to the limit of
+ * the pool are kept mapped and handed to later registrations of the same size class.
+ *
+ * A pooled page does not carry the name of its variable but a name of the pool (namespace independent,
+ * "memshare.pool.<pid>.<start>.<n>" with the start time of the process); the metadata page of the variable records it
+ * in SegmentHeader::data_name, which is what viewers map. The pages of the pool are owned by the process,
+ * memshare_reclaim removes those of dead processes.
+ *
+ * The pool is disabled (limit 0) until a limit is set: pooled pages stay in shared memory after their variables were
+ * released.
+ *
+ * This file does not depend on R; errors are reported as std::runtime_error. All functions are thread-safe.
+ */
+
+const std::uint64_t POOL_DEFAULT_LIMIT = 0;
+
+/**
+ * The size of the data pages of the size class of bytes: whole pages, and above four pages the next quarter step
+ * between powers of two (at most 25% are wasted).
+ */
+std::size_t pool_size_class(std::size_t bytes);
+
+/**
+ * A data page of at least bytes bytes: a pooled one of its size class or a new one with a name of the pool.
+ *
+ * @param populate    Whether a new page is mapped up front (see MemoryPage::alloc); pooled pages are mapped already.
+ * @param reused      Set to whether the page comes from the pool; its content is undefined then.
+ *
+ * @result  The page or nullptr if the size class exceeds the limit of the pool; the caller allocates the page then.
+ */
+std::unique_ptr<MemoryPage> pool_take(std::size_t bytes, bool populate, bool& reused);
+
+/**
+ * Returns a data page obtained by pool_take to the pool. Pages that would exceed the limit are not taken.
+ *
+ * @param page    The page; it is moved into the pool if the result is true and left untouched otherwise.
+ */
+bool pool_give(std::unique_ptr<MemoryPage>& page);
+
+/**
+ * Sets the byte limit of the pool; 0 disables it. Pooled pages beyond the new limit are removed.
+ */
+void pool_set_limit(std::uint64_t bytes);
+
+struct PoolStats {
+    std::uint64_t limit;
+    std::uint64_t bytes;        // size of the pooled pages
+    std::uint64_t segments;     // number of pooled pages
+    std::uint64_t hits;         // registrations served from the pool
+    std::uint64_t misses;       // registrations the pool created a new page for
+};
+
+PoolStats pool_stats();
+
+/**
+ * Whether a shared memory name is a page of a pool and which process created it.
+ *
+ * @param pid, start    Set to the id and the start time (see process_start_time) of the process.
+ */
+bool pool_page_owner(const std::string& name, std::int64_t& pid, std::uint64_t& start);
@@ -0,0 +1,192 @@
+#include "reclaim.h"
+#include "arena.h"
+#include "catalog.h"
+#include "memory_page.h"
+#include "pool.h"
+#include "segment_header.h"
+
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <set>
+#include <sstream>
+
+#ifndef _WIN32
+#include <signal.h> // kill
+#include <unistd.h>
+#endif
+#ifdef __linux__
+#include <dirent.h>
+#endif
+
+std::int64_t current_pid() {
+#ifdef _WIN32
+    return static_cast<std::int64_t>(GetCurrentProcessId());
+#else
+    return static_cast<std::int64_t>(getpid());
+#endif
+}
+
+std::uint64_t process_start_time(std::int64_t pid) {
+#ifdef __linux__
+    // field 22 of /proc/<pid>/stat; the command name (field 2) is in parentheses and may contain spaces
+    std::ifstream stat("/proc/" + std::to_string(pid) + "/stat");
+    std::string line;
+    if (!std::getline(stat, line)) return 0;
+    std::size_t close = line.rfind(')');
+    if (close == std::string::npos) return 0;
+    std::istringstream fields(line.substr(close + 1));
+    std::string field;
+    // the first field after the command name is field 3
+    for (int i = 3; i <= 22; i++) {
+        if (!(fields >> field)) return 0;
+    }
+    return std::strtoull(field.c_str(), nullptr, 10);
+#else
+    (void) pid;
+    return 0;
+#endif
+}
+
+bool process_alive(std::int64_t pid, std::uint64_t start) {
+    if (pid <= 0) return false;
+#ifdef _WIN32
+    HANDLE process = OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, static_cast<DWORD>(pid));
+    if (process == NULL) return GetLastError() == ERROR_ACCESS_DENIED;
+    DWORD exitCode = 0;
+    bool running = GetExitCodeProcess(process, &exitCode) && exitCode == STILL_ACTIVE;
+    CloseHandle(process);
+    return running;
+#else
+    if (kill(static_cast<pid_t>(pid), 0) != 0 && errno != EPERM) return false;
+    // the id might have been reused by a younger process
+    if (start != 0) {
+        std::uint64_t current = process_start_time(pid);
+        if (current != 0 && current != start) return false;
+    }
+    return true;
+#endif
+}
+
+#ifdef __linux__
+namespace {
+
+const std::string SHM_DIR = "/dev/shm/";
+
+// paths of all files (including /dev/shm) mapped by any process we may inspect
+std::set<std::string> mapped_files() {
+    std::set<std::string> mapped;
+    DIR* proc = opendir("/proc");
+    if (proc == nullptr) return mapped;
+    while (struct dirent* entry = readdir(proc)) {
+        if (entry->d_name[0] < '0' || entry->d_name[0] > '9') continue;
+        // processes of other users cannot be inspected; they can only map our segments if those are world-readable
+        std::ifstream maps(std::string("/proc/") + entry->d_name + "/maps");
+        std::string line;
+        while (std::getline(maps, line)) {
+            // the path is the last field and starts with a slash
+            std::size_t pos = line.find(" /");
+            if (pos == std::string::npos) continue;
+            std::string name = line.substr(pos + 1);
+            std::size_t deleted = name.find(" (deleted)");
+            if (deleted != std::string::npos) name.resize(deleted);
+            mapped.insert(name);
+        }
+    }
+    closedir(proc);
+    return mapped;
+}
+
+// read the first bytes of a /dev/shm file; false if it is smaller
+bool read_prefix(const std::string& name, void* out, std::size_t bytes) {
+    std::ifstream file(SHM_DIR + name, std::ios::binary);
+    return static_cast<bool>(file.read(static_cast<char*>(out), bytes));
+}
+
+bool ends_with(const std::string& s, const std::string& suffix) {
+    return s.size() >= suffix.size() && s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+}
+#endif
+
+std::vector<ReclaimedSegment> reclaim_orphans(bool dryRun) {
+    std::vector<ReclaimedSegment> result;
+#ifdef __linux__
+    DIR* dir = opendir(SHM_DIR.c_str());
+    if (dir == nullptr) return result;
+    std::vector<std::string> names;
+    while (struct dirent* entry = readdir(dir)) {
+        if (entry->d_name[0] != '.') names.push_back(entry->d_name);
+    }
+    closedir(dir);
+
+    std::set<std::string> mapped = mapped_files();
+    for (const std::string& name : names) {
+        if (ends_with(name, ".cat.")) {
+            // catalogs: drop the entries of dead owners, the catalog vanishes with its last entry
+            std::string name_space = name.substr(0, name.size() - 5);
+            std::vector<CatalogRecord> dead = catalog_prune(name_space, dryRun);
+            std::size_t remaining = catalog_list(name_space).size();
+            if (!dead.empty() && remaining == (dryRun ? dead.size() : 0)) {
+                result.push_back({name, catalog_bytes()});
+            }
+            continue;
+        }
+
+        // data pages of the pool of a dead process (see pool.h); those in use are removed with their metadata page
+        std::int64_t poolPid;
+        std::uint64_t poolStart;
+        if (pool_page_owner(name, poolPid, poolStart)) {
+            if (process_alive(poolPid, poolStart) || mapped.count(SHM_DIR + name) > 0) continue;
+            struct stat st;
+            if (stat((SHM_DIR + name).c_str(), &st) != 0) continue;
+            if (!dryRun) MemoryPage::unlink(name);
+            result.push_back({name, static_cast<std::uint64_t>(st.st_size)});
+            continue;
+        }
+
+        // control pages of published variables are recognized by their magic; the generations are ordinary pages
+        alignas(VersionControl) unsigned char control[sizeof(VersionControl)];
+        const VersionControl* c = static_cast<const VersionControl*>(static_cast<const void*>(control));
+        if (read_prefix(name, control, sizeof(VersionControl)) && c->magic.load() == VERSION_MAGIC) {
+            if (process_alive(c->owner_pid, c->owner_start) || mapped.count(SHM_DIR + name) > 0) continue;
+            if (!dryRun) MemoryPage::unlink(name);
+            result.push_back({name, VERSION_CONTROL_BYTES});
+            continue;
+        }
+
+        // arenas as well (see arena.h); their variables are dropped from the catalog with the lease of their owner
+        alignas(ArenaHeader) unsigned char arena[sizeof(ArenaHeader)];
+        const ArenaHeader* a = static_cast<const ArenaHeader*>(static_cast<const void*>(arena));
+        if (ends_with(name, ".arena.") && read_prefix(name, arena, sizeof(ArenaHeader)) && a->magic.load() == ARENA_MAGIC) {
+            if (process_alive(a->owner_pid, a->owner_start) || mapped.count(SHM_DIR + name) > 0) continue;
+            if (!dryRun) MemoryPage::unlink(name);
+            result.push_back({name, a->bytes});
+            continue;
+        }
+
+        // metadata pages are recognized by their header
+        alignas(SegmentHeader) unsigned char buffer[sizeof(SegmentHeader)];
+        if (!read_prefix(name, buffer, sizeof(SegmentHeader))) continue;
+        const SegmentHeader* h = static_cast<const SegmentHeader*>(static_cast<const void*>(buffer));
+        if (h->magic != SEGMENT_MAGIC || h->version != SEGMENT_VERSION) continue;
+
+        std::string dataName(h->data_name, strnlen(h->data_name, SEGMENT_NAME_BYTES));
+        std::string backing(h->backing_path, strnlen(h->backing_path, SEGMENT_PATH_BYTES));
+        if (dataName.empty() || process_alive(h->owner_pid, h->owner_start)) continue;
+        if (mapped.count(SHM_DIR + name) > 0 || mapped.count(SHM_DIR + dataName) > 0 ||
+            (!backing.empty() && mapped.count(backing) > 0)) continue;
+
+        // the data of a restored page lives in its snapshot file which is kept
+        if (!dryRun) {
+            if (backing.empty()) MemoryPage::unlink(dataName);
+            MemoryPage::unlink(name);
+        }
+        result.push_back({name, (backing.empty() ? h->data_bytes : 0) + h->meta_bytes});
+    }
+#else
+    (void) dryRun;
+#endif
+    return result;
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * Lease-based ownership of shared memory segments.
+ *
+ * Owners record their process id and the start time of their process in the header of the metadata page (see
+ * segment_header.h) and in the catalog of the namespace. A segment whose owner is gone (no process with the id, or
+ * one with a different start time, i.e. the id was reused) and which is not mapped by any process is an orphan:
+ * its owner died before MemoryPage::~MemoryPage could unlink it.
+ *
+ * The data pages pooled by a dead process (see pool.h) and the arenas of dead owners (see arena.h) are orphans as well.
+ *
+ * Orphans can only be enumerated where shared memory is a file system (/dev/shm on Linux). On Windows the sections
+ * vanish with their last handle anyway; on macOS they cannot be listed and the scan is a no-op.
+ *
+ * This file does not depend on R.
+ */
+
+/**
+ * Id of the calling process.
+ */
+std::int64_t current_pid();
+
+/**
+ * Start time of a process in an OS-specific unit (clock ticks since boot on Linux); 0 if unknown.
+ */
+std::uint64_t process_start_time(std::int64_t pid);
+
+/**
+ * Whether the process that recorded (pid, start) is still running. A start time of 0 only checks the id.
+ */
+bool process_alive(std::int64_t pid, std::uint64_t start);
+
+/**
+ * A segment removed (or found, for a dry run) by reclaim_orphans.
+ */
+struct ReclaimedSegment {
+    std::string name;       // name of the metadata page (or of the catalog or a control page)
+    std::uint64_t bytes;    // size of the data and metadata pages
+};
+
+/**
+ * Scan the shared memory of the system for memshare segments of dead owners that are not mapped by any process and
+ * unlink them. Entries of dead owners are removed from the catalogs as well.
+ *
+ * @param dryRun      Only report the orphans without removing them.
+ */
+std::vector<ReclaimedSegment> reclaim_orphans(bool dryRun);
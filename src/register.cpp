@@ -4,12 +4,43 @@
 
 #include "shared_memory.h"
 #include "metadata.h"
+#include "catalog.h"
+#include "reclaim.h"
+#include "pool.h"
+#include "arena.h"
+#include "numa.h"
 
-void registerVariables(std::string name_space, List vars) {
+// register a small double matrix or vector in the arena of the namespace (see arena.h); false if it does not go there
+static bool registerArenaVariable(const std::string& name_space, const std::string& varname, SEXP obj, std::uint64_t maxBytes) {
+    if (TYPEOF(obj) != REALSXP || static_cast<std::uint64_t>(Rf_xlength(obj)) * sizeof(double) > maxBytes) return false;
+    if (varname.size() >= ARENA_NAME_BYTES) return false;
+    check_variable_name(varname);
+    if (pages.find(name_space + "." + varname) != pages.end()) stop("Variable " + name_space + "." + varname + " is already registered!");
+    std::uint64_t bytes = 0;
+    if (Rf_isMatrix(obj)) {
+        NumericMatrix mat(obj);
+        bytes = arena_register(name_space, varname, true, mat.nrow(), mat.ncol(), mat.begin());
+    } else if (Rf_isVector(obj)) {
+        NumericVector vec(obj);
+        bytes = arena_register(name_space, varname, false, vec.size(), 1, vec.begin());
+    }
+    if (bytes == 0) return false;
+    try {
+        catalog_register(name_space, varname, bytes);
+    } catch (...) {
+        arena_release(name_space, varname);
+        throw;
+    }
+    return true;
+}
+
+void registerVariables(std::string name_space, List vars, int threads, std::string placement, bool stats) {
 #ifdef _WIN32
     // For windows we prepend the namespace identifier by "Local\\" because otherwise the shared memory is shared system-wide (instead of user-wide) which needs admin privileges
     name_space = "Local\\" + name_space;   
 #endif
+    std::uint64_t arenaBytes = arena_max_variable(name_space);
+    numa_placement policy = numa_parse_placement(placement);
 
     for (int i = 0; i < vars.size(); ++i) {
         Rcpp::CharacterVector varnames = vars.names();
@@ -17,10 +48,44 @@ void registerVariables(std::string name_space, List vars) {
 
         SEXP obj = vars[i];
 
+        // small variables go into the arena of the namespace if this session created one; they carry no statistics
+        if (arenaBytes > 0 && !stats && registerArenaVariable(name_space, varname, obj, arenaBytes)) continue;
+
         // register a page for every variable in the list.
-        registerPage(name_space + "." + varname, name_space + ".md." + varname, obj);
+        registerPage(name_space + "." + varname, name_space + ".md." + varname, obj, threads, policy, stats);
     }
 }
+int registerVariablesAsync(std::string name_space, List vars, int threads) {
+#ifdef _WIN32
+    // For windows we prepend the namespace identifier by "Local\\" because otherwise the shared memory is shared system-wide (instead of user-wide) which needs admin privileges
+    name_space = "Local\\" + name_space;
+#endif
+    Rcpp::CharacterVector varnames = vars.names();
+    std::vector<std::string> names, metanames;
+    for (int i = 0; i < vars.size(); ++i) {
+        std::string varname = Rcpp::as<std::string>(varnames[i]);
+        names.push_back(name_space + "." + varname);
+        metanames.push_back(name_space + ".md." + varname);
+    }
+    return registerPagesAsync(names, metanames, vars, threads);
+}
+
+bool readyVariablesAsync(int id) {
+    return readyPagesAsync(id);
+}
+
+void waitVariablesAsync(int id) {
+    waitPagesAsync(id);
+}
+
+double publishVariable(std::string name_space, std::string varname, SEXP obj, int threads) {
+#ifdef _WIN32
+    // For windows we prepend the namespace identifier by "Local\\" because otherwise the shared memory is shared system-wide (instead of user-wide) which needs admin privileges
+    name_space = "Local\\" + name_space;
+#endif
+    return static_cast<double>(publishPage(name_space + "." + varname, name_space + ".md." + varname, obj, threads));
+}
+
 void releaseVariables(std::string name_space, CharacterVector vars) {
 #ifdef _WIN32
     // For windows we prepend the namespace identifier by "Local\\" because otherwise the shared memory is shared system-wide (instead of user-wide) which needs admin privileges
@@ -29,6 +94,10 @@ void releaseVariables(std::string name_space, CharacterVector vars) {
     for (long int i = 0; i < vars.size(); ++i) {
         std::string varname = Rcpp::as<std::string>(vars[i]);
 
+        if (arena_release(name_space, varname)) {
+            catalog_unregister(name_space, varname);
+            continue;
+        }
         // release the page of everyy variable in the list.
         releasePage(name_space + "." + varname);
     }
@@ -36,18 +105,147 @@ void releaseVariables(std::string name_space, CharacterVector vars) {
 
 List pageList() {
     std::vector<std::string> pageNames = getSharedPages();
+    std::vector<std::string> arenaNames = arena_variables();
+    pageNames.insert(pageNames.end(), arenaNames.begin(), arenaNames.end());
     List result(pageNames.size());
     for (std::size_t i = 0; i < pageNames.size(); i++)
         result[i] = pageNames[i];
     return result;
 }
 
-extern "C" SEXP C_registerVariables(SEXP name_spaceSEXP, SEXP varsSEXP) {
+DataFrame pageStats() {
+    return getSharedStats(true);
+}
+
+DataFrame namespaceCatalog(std::string name_space) {
+#ifdef _WIN32
+    // For windows we prepend the namespace identifier by "Local\\" because otherwise the shared memory is shared system-wide (instead of user-wide) which needs admin privileges
+    name_space = "Local\\" + name_space;
+#endif
+    std::vector<CatalogRecord> records = catalog_list(name_space);
+    R_xlen_t n = records.size();
+    CharacterVector variable(n);
+    NumericVector ownerPid(n), bytes(n), refcount(n);
+    for (R_xlen_t i = 0; i < n; i++) {
+        variable[i] = records[i].name;
+        ownerPid[i] = static_cast<double>(records[i].owner_pid);
+        bytes[i] = static_cast<double>(records[i].bytes);
+        refcount[i] = static_cast<double>(records[i].refcount);
+    }
+    return DataFrame::create(
+        Named("variable") = variable,
+        Named("owner_pid") = ownerPid,
+        Named("bytes") = bytes,
+        Named("refcount") = refcount,
+        Named("stringsAsFactors") = false
+    );
+}
+
+DataFrame memshareReclaim(bool dryRun) {
+    std::vector<ReclaimedSegment> reclaimed = reclaim_orphans(dryRun);
+    R_xlen_t n = reclaimed.size();
+    CharacterVector segment(n);
+    NumericVector bytes(n);
+    for (R_xlen_t i = 0; i < n; i++) {
+        segment[i] = reclaimed[i].name;
+        bytes[i] = static_cast<double>(reclaimed[i].bytes);
+    }
+    return DataFrame::create(
+        Named("segment") = segment,
+        Named("bytes") = bytes,
+        Named("stringsAsFactors") = false
+    );
+}
+
+NumericVector memshareQuota(std::string name_space, double bytes) {
+#ifdef _WIN32
+    // For windows we prepend the namespace identifier by "Local\\" because otherwise the shared memory is shared system-wide (instead of user-wide) which needs admin privileges
+    if (!name_space.empty()) name_space = "Local\\" + name_space;
+#endif
+    if (!ISNAN(bytes)) {
+        setPageQuota(name_space, (bytes <= 0 || !R_FINITE(bytes)) ? 0 : static_cast<std::uint64_t>(bytes));
+    }
+    std::uint64_t used;
+    std::uint64_t quota = getPageQuota(name_space, used);
+    return NumericVector::create(
+        Named("quota") = quota == 0 ? NA_REAL : static_cast<double>(quota),
+        Named("used") = static_cast<double>(used)
+    );
+}
+
+NumericVector memshareNuma(int worker, int workers) {
+    double node = NA_REAL;
+    if (worker != NA_INTEGER) {
+        if (workers == NA_INTEGER || worker < 1 || worker > workers) stop("worker has to be one of 1, ..., workers!");
+        int pinned = numa_pin_worker(worker - 1, workers);
+        if (pinned >= 0) node = pinned + 1;
+    }
+    return NumericVector::create(
+        Named("nodes") = numa_node_count(),
+        Named("node") = node
+    );
+}
+
+NumericVector memshareArena(std::string name_space, double bytes, double maxVariableBytes) {
+#ifdef _WIN32
+    // For windows we prepend the namespace identifier by "Local\\" because otherwise the shared memory is shared system-wide (instead of user-wide) which needs admin privileges
+    name_space = "Local\\" + name_space;
+#endif
+    if (!ISNAN(bytes)) {
+        if (bytes <= 0) {
+            arena_destroy(name_space);
+        } else {
+            if (!R_FINITE(bytes) || ISNAN(maxVariableBytes) || maxVariableBytes <= 0) stop("The size of the arena has to be finite and maxVariableBytes positive!");
+            checkPageQuota(name_space, arena_section_bytes(static_cast<std::uint64_t>(bytes)));
+            arena_create(name_space, static_cast<std::uint64_t>(bytes), static_cast<std::uint64_t>(std::min(maxVariableBytes, bytes)));
+        }
+    }
+    std::uint64_t size = 0, used = 0, count = 0, maxBytes = 0;
+    bool present = arena_usage(name_space, size, used, count, maxBytes);
+    return NumericVector::create(
+        Named("bytes") = present ? static_cast<double>(size) : NA_REAL,
+        Named("used") = static_cast<double>(used),
+        Named("variables") = static_cast<double>(count),
+        Named("maxVariableBytes") = present ? static_cast<double>(maxBytes) : NA_REAL
+    );
+}
+
+NumericVector memsharePool(double bytes) {
+    if (!ISNAN(bytes)) {
+        pool_set_limit((bytes <= 0 || !R_FINITE(bytes)) ? 0 : static_cast<std::uint64_t>(bytes));
+    }
+    PoolStats stats = pool_stats();
+    return NumericVector::create(
+        Named("limit") = static_cast<double>(stats.limit),
+        Named("bytes") = static_cast<double>(stats.bytes),
+        Named("segments") = static_cast<double>(stats.segments),
+        Named("hits") = static_cast<double>(stats.hits),
+        Named("misses") = static_cast<double>(stats.misses)
+    );
+}
+
+void snapshotVariable(std::string name_space, std::string varname, std::string metaPath, std::string dataPath) {
+#ifdef _WIN32
+    // For windows we prepend the namespace identifier by "Local\\" because otherwise the shared memory is shared system-wide (instead of user-wide) which needs admin privileges
+    name_space = "Local\\" + name_space;
+#endif
+    snapshotPage(name_space + "." + varname, name_space + ".md." + varname, metaPath, dataPath);
+}
+
+void restoreVariable(std::string name_space, std::string varname, std::string metaPath, std::string dataPath) {
+#ifdef _WIN32
+    // For windows we prepend the namespace identifier by "Local\\" because otherwise the shared memory is shared system-wide (instead of user-wide) which needs admin privileges
+    name_space = "Local\\" + name_space;
+#endif
+    restorePage(name_space + "." + varname, name_space + ".md." + varname, metaPath, dataPath);
+}
+
+extern "C" SEXP C_registerVariables(SEXP name_spaceSEXP, SEXP varsSEXP, SEXP threadsSEXP, SEXP placementSEXP, SEXP statsSEXP) {
     try {
         std::string name_space = as<std::string>(name_spaceSEXP);
         List vars = as<List>(varsSEXP);
 
-        registerVariables(name_space, vars);
+        registerVariables(name_space, vars, as<int>(threadsSEXP), as<std::string>(placementSEXP), as<bool>(statsSEXP));
 
         return R_NilValue; // function returns void
     } catch (std::exception &e) {
@@ -56,6 +254,43 @@ extern "C" SEXP C_registerVariables(SEXP name_spaceSEXP, SEXP varsSEXP) {
         Rf_error("registerVariables unknown error");
     }
 }
+extern "C" SEXP C_registerVariablesAsync(SEXP name_spaceSEXP, SEXP varsSEXP, SEXP threadsSEXP) {
+    try {
+        return wrap(registerVariablesAsync(as<std::string>(name_spaceSEXP), as<List>(varsSEXP), as<int>(threadsSEXP)));
+    } catch (std::exception &e) {
+        Rf_error("registerVariablesAsync error: %s", e.what());
+    } catch (...) {
+        Rf_error("registerVariablesAsync unknown error");
+    }
+}
+extern "C" SEXP C_readyVariablesAsync(SEXP idSEXP) {
+    try {
+        return wrap(readyVariablesAsync(as<int>(idSEXP)));
+    } catch (std::exception &e) {
+        Rf_error("ready error: %s", e.what());
+    } catch (...) {
+        Rf_error("ready unknown error");
+    }
+}
+extern "C" SEXP C_waitVariablesAsync(SEXP idSEXP) {
+    try {
+        waitVariablesAsync(as<int>(idSEXP));
+        return R_NilValue; // function returns void
+    } catch (std::exception &e) {
+        Rf_error("wait error: %s", e.what());
+    } catch (...) {
+        Rf_error("wait unknown error");
+    }
+}
+extern "C" SEXP C_publishVariable(SEXP name_spaceSEXP, SEXP varnameSEXP, SEXP objSEXP, SEXP threadsSEXP) {
+    try {
+        return wrap(publishVariable(as<std::string>(name_spaceSEXP), as<std::string>(varnameSEXP), objSEXP, as<int>(threadsSEXP)));
+    } catch (std::exception &e) {
+        Rf_error("publish error: %s", e.what());
+    } catch (...) {
+        Rf_error("publish unknown error");
+    }
+}
 extern "C" SEXP C_releaseVariables(SEXP name_spaceSEXP, SEXP varsSEXP) {
     try {
         std::string name_space = as<std::string>(name_spaceSEXP);
@@ -73,3 +308,86 @@ extern "C" SEXP C_releaseVariables(SEXP name_spaceSEXP, SEXP varsSEXP) {
 extern "C" SEXP C_pageList() {
     return pageList();
 }
+extern "C" SEXP C_pageStats() {
+    try {
+        return pageStats();
+    } catch (std::exception &e) {
+        Rf_error("pageStats error: %s", e.what());
+    } catch (...) {
+        Rf_error("pageStats unknown error");
+    }
+}
+extern "C" SEXP C_namespaceCatalog(SEXP name_spaceSEXP) {
+    try {
+        return namespaceCatalog(as<std::string>(name_spaceSEXP));
+    } catch (std::exception &e) {
+        Rf_error("namespaceCatalog error: %s", e.what());
+    } catch (...) {
+        Rf_error("namespaceCatalog unknown error");
+    }
+}
+extern "C" SEXP C_memshareReclaim(SEXP dryRunSEXP) {
+    try {
+        return memshareReclaim(as<bool>(dryRunSEXP));
+    } catch (std::exception &e) {
+        Rf_error("memshare_reclaim error: %s", e.what());
+    } catch (...) {
+        Rf_error("memshare_reclaim unknown error");
+    }
+}
+extern "C" SEXP C_memshareQuota(SEXP name_spaceSEXP, SEXP bytesSEXP) {
+    try {
+        return memshareQuota(as<std::string>(name_spaceSEXP), as<double>(bytesSEXP));
+    } catch (std::exception &e) {
+        Rf_error("memshare_quota error: %s", e.what());
+    } catch (...) {
+        Rf_error("memshare_quota unknown error");
+    }
+}
+extern "C" SEXP C_memshareNuma(SEXP workerSEXP, SEXP workersSEXP) {
+    try {
+        return memshareNuma(as<int>(workerSEXP), as<int>(workersSEXP));
+    } catch (std::exception &e) {
+        Rf_error("memshare_numa error: %s", e.what());
+    } catch (...) {
+        Rf_error("memshare_numa unknown error");
+    }
+}
+extern "C" SEXP C_memshareArena(SEXP name_spaceSEXP, SEXP bytesSEXP, SEXP maxVariableBytesSEXP) {
+    try {
+        return memshareArena(as<std::string>(name_spaceSEXP), as<double>(bytesSEXP), as<double>(maxVariableBytesSEXP));
+    } catch (std::exception &e) {
+        Rf_error("memshare_arena error: %s", e.what());
+    } catch (...) {
+        Rf_error("memshare_arena unknown error");
+    }
+}
+extern "C" SEXP C_memsharePool(SEXP bytesSEXP) {
+    try {
+        return memsharePool(as<double>(bytesSEXP));
+    } catch (std::exception &e) {
+        Rf_error("memshare_pool error: %s", e.what());
+    } catch (...) {
+        Rf_error("memshare_pool unknown error");
+    }
+}
+extern "C" SEXP C_snapshotVariable(SEXP name_spaceSEXP, SEXP varnameSEXP, SEXP metaPathSEXP, SEXP dataPathSEXP) {
+    try {
+        snapshotVariable(as<std::string>(name_spaceSEXP), as<std::string>(varnameSEXP), as<std::string>(metaPathSEXP), as<std::string>(dataPathSEXP));
+        return R_NilValue; // function returns void
+    } catch (std::exception &e) {
+        Rf_error("snapshotNamespace error: %s", e.what());
+    } catch (...) {
+        Rf_error("snapshotNamespace unknown error");
+    }
+}
+extern "C" SEXP C_restoreVariable(SEXP name_spaceSEXP, SEXP varnameSEXP, SEXP metaPathSEXP, SEXP dataPathSEXP) {
+    try {
+        restoreVariable(as<std::string>(name_spaceSEXP), as<std::string>(varnameSEXP), as<std::string>(metaPathSEXP), as<std::string>(dataPathSEXP));
+        return R_NilValue; // function returns void
+    } catch (std::exception &e) {
+        Rf_error("restoreNamespace error: %s", e.what());
+    } catch (...) {
+        Rf_error("restoreNamespace unknown error");
+    }
+}
@@ -8,8 +8,44 @@ using namespace Rcpp;
  * 
  * @param name_spaceSEXP        A character (R-string) identifying the memory space we are working in.
  * @param varsSEXP              A list of variables to register in the shared memory space.
+ * @param threads               Number of threads copying large variables (0 = all available).
+ * @param placement             NUMA placement of the data pages: "default", "interleave" or "blocks" (see numa.h).
+ * @param stats                 Whether to compute the column statistics of matrices and vectors (see column_stats.h).
  */
-void registerVariables(std::string name_space, List vars);
+void registerVariables(std::string name_space, List vars, int threads, std::string placement = "default", bool stats = false);
+
+/**
+ * Registers a list of variables on a background thread; see registerPagesAsync.
+ * 
+ * @param name_space        A string identifying the memory space we are working in.
+ * @param vars              A list of variables to register in the shared memory space.
+ * @param threads           Number of threads copying large variables (0 = all available).
+ * 
+ * @result  The id of the registration for readyVariablesAsync and waitVariablesAsync.
+ */
+int registerVariablesAsync(std::string name_space, List vars, int threads);
+
+/**
+ * Whether an asynchronous registration has finished.
+ */
+bool readyVariablesAsync(int id);
+
+/**
+ * Waits for an asynchronous registration and takes ownership of its variables; rethrows its error.
+ */
+void waitVariablesAsync(int id);
+
+/**
+ * Publishes a new generation of a versioned variable; see publishPage.
+ * 
+ * @param name_space        A string identifying the memory space we are working in.
+ * @param varname           The variable name.
+ * @param obj               The new value (double matrix, double vector or a list of these).
+ * @param threads           Number of threads copying large variables (0 = all available).
+ * 
+ * @result  The generation published, starting at 1.
+ */
+double publishVariable(std::string name_space, std::string varname, SEXP obj, int threads);
 
 /**
  * Releases a list of variables from a shared memory space.
@@ -26,6 +62,89 @@ void releaseVariables(std::string name_space, CharacterVector vars);
  */
 List pageList();
 
+/**
+ * Retrieves the statistics (sizes, registration timings, attach counters, ...) of the variables owned by the current process.
+ * 
+ * @result  data.frame with one row per variable.
+ */
+DataFrame pageStats();
+
+/**
+ * Retrieves the catalog of a namespace, i.e. the variables registered in it by any process.
+ * 
+ * @param name_space        A string identifying the memory space we are working in.
+ * 
+ * @result  data.frame with the columns variable, owner_pid, bytes and refcount (number of attached views).
+ */
+DataFrame namespaceCatalog(std::string name_space);
+
+/**
+ * Removes the shared memory segments of crashed owners that are not mapped by any process (see reclaim.h).
+ * 
+ * @param dryRun            Only report the orphans.
+ * 
+ * @result  data.frame with the columns segment and bytes of the reclaimed segments.
+ */
+DataFrame memshareReclaim(bool dryRun);
+
+/**
+ * Sets and/or gets the byte quota of a namespace or the global quota of this process (see setPageQuota).
+ * 
+ * @param name_space        A string identifying the memory space, "" for the global quota.
+ * @param bytes             The new quota; NA keeps the current one, 0 or Inf removes it.
+ * 
+ * @result  Named vector c(quota, used); quota is NA if there is none.
+ */
+NumericVector memshareQuota(std::string name_space, double bytes);
+
+/**
+ * Describes the NUMA nodes of the machine and optionally pins the calling process as a worker (see numa.h).
+ * 
+ * @param worker    The 1-based number of the worker or NA to only describe the nodes.
+ * @param workers   The number of workers.
+ * 
+ * @result  Named vector c(nodes, node): the number of nodes and the 1-based node the worker was pinned to (NA if not).
+ */
+NumericVector memshareNuma(int worker, int workers);
+
+/**
+ * Creates, removes and/or describes the arena of a namespace owned by this process (see arena.h).
+ * 
+ * @param name_space        A string identifying the memory space.
+ * @param bytes             Size of the arena to create; NA only describes it, 0 removes it.
+ * @param maxVariableBytes  Variables up to this size are registered in the arena.
+ * 
+ * @result  Named vector c(bytes, used, variables, maxVariableBytes); bytes is NA if there is no arena.
+ */
+NumericVector memshareArena(std::string name_space, double bytes, double maxVariableBytes);
+
+/**
+ * Sets and/or gets the byte limit of the pool of data pages of this process (see pool.h).
+ * 
+ * @param bytes             The new limit; NA keeps the current one, 0 disables the pool.
+ * 
+ * @result  Named vector c(limit, bytes, segments, hits, misses).
+ */
+NumericVector memsharePool(double bytes);
+
+/**
+ * Writes a variable (owned or registered by another process) in its native layout to the files metaPath and dataPath.
+ * 
+ * @param name_space        A string identifying the memory space we are working in.
+ * @param varname           The variable name.
+ * @param metaPath, dataPath    Paths of the snapshot files.
+ */
+void snapshotVariable(std::string name_space, std::string varname, std::string metaPath, std::string dataPath);
+
+/**
+ * Registers a variable from a snapshot; its data is mapped from dataPath instead of being read and copied.
+ * 
+ * @param name_space        A string identifying the memory space we are working in.
+ * @param varname           The variable name.
+ * @param metaPath, dataPath    Paths of the snapshot files; dataPath has to be absolute.
+ */
+void restoreVariable(std::string name_space, std::string varname, std::string metaPath, std::string dataPath);
+
 
 
 
@@ -38,10 +157,25 @@ List pageList();
  * 
  * @param name_spaceSEXP        A character (R-string) identifying the memory space we are working in.
  * @param varsSEXP              A list of variables to register in the shared memory space.
+ * @param threadsSEXP           Number of threads copying large variables.
+ * @param placementSEXP         The NUMA placement of the data pages.
+ * @param statsSEXP             A logical whether to compute column statistics.
  * 
  * @result  NULL (no other way when manually registering Rcpp functions)
  */
-extern "C" SEXP C_registerVariables(SEXP name_spaceSEXP, SEXP varsSEXP);
+extern "C" SEXP C_registerVariables(SEXP name_spaceSEXP, SEXP varsSEXP, SEXP threadsSEXP, SEXP placementSEXP, SEXP statsSEXP);
+
+/**
+ * Wrapper functions for registerVariablesAsync, readyVariablesAsync and waitVariablesAsync above.
+ */
+extern "C" SEXP C_registerVariablesAsync(SEXP name_spaceSEXP, SEXP varsSEXP, SEXP threadsSEXP);
+extern "C" SEXP C_readyVariablesAsync(SEXP idSEXP);
+extern "C" SEXP C_waitVariablesAsync(SEXP idSEXP);
+
+/**
+ * Wrapper function for publishVariable above.
+ */
+extern "C" SEXP C_publishVariable(SEXP name_spaceSEXP, SEXP varnameSEXP, SEXP objSEXP, SEXP threadsSEXP);
 
 /**
  * Wrapper function for releaseVariables above. It releases a list of variables from a shared memory space.
@@ -59,3 +193,44 @@ extern "C" SEXP C_releaseVariables(SEXP name_spaceSEXP, SEXP varsSEXP);
  * @result  List of Characters stating the variables in current ownership of this process.
  */
 extern "C" SEXP C_pageList();
+
+/**
+ * Wrapper function for pageStats above.
+ */
+extern "C" SEXP C_pageStats();
+
+/**
+ * Wrapper function for namespaceCatalog above.
+ */
+extern "C" SEXP C_namespaceCatalog(SEXP name_spaceSEXP);
+
+/**
+ * Wrapper function for memshareReclaim above.
+ */
+extern "C" SEXP C_memshareReclaim(SEXP dryRunSEXP);
+
+/**
+ * Wrapper function for memshareQuota above.
+ */
+extern "C" SEXP C_memshareQuota(SEXP name_spaceSEXP, SEXP bytesSEXP);
+
+/**
+ * Wrapper function for memshareNuma above.
+ */
+extern "C" SEXP C_memshareNuma(SEXP workerSEXP, SEXP workersSEXP);
+
+/**
+ * Wrapper function for memshareArena above.
+ */
+extern "C" SEXP C_memshareArena(SEXP name_spaceSEXP, SEXP bytesSEXP, SEXP maxVariableBytesSEXP);
+
+/**
+ * Wrapper function for memsharePool above.
+ */
+extern "C" SEXP C_memsharePool(SEXP bytesSEXP);
+
+/**
+ * Wrapper functions for snapshotVariable and restoreVariable above.
+ */
+extern "C" SEXP C_snapshotVariable(SEXP name_spaceSEXP, SEXP varnameSEXP, SEXP metaPathSEXP, SEXP dataPathSEXP);
+extern "C" SEXP C_restoreVariable(SEXP name_spaceSEXP, SEXP varnameSEXP, SEXP metaPathSEXP, SEXP dataPathSEXP);
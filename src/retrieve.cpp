@@ -5,8 +5,29 @@
 #include "altrep.h"
 #include "shared_memory.h"
 #include "metadata.h"
+#include "catalog.h"
+#include "arena.h"
 
-List retrieveViews(std::string name_space, CharacterVector vars) {
+// attaches to a variable in the arena of a namespace; R_NilValue if it is not there
+static SEXP retrieveArenaView(const std::string& name_space, const std::string& varname, size_t firstCol, size_t numCols) {
+    bool isMatrix = false, attached = false;
+    size_t nrow = 0, ncol = 0;
+    const double* data = arena_view(name_space, varname, isMatrix, nrow, ncol, attached);
+    if (data == nullptr) return R_NilValue;
+    if (attached) catalog_attach(name_space, varname, 1);
+
+    if (!isMatrix) {
+        if (numCols > 0) stop("cols is only supported for matrices!");
+        return make_altrep_vector(const_cast<double*>(data), nrow);
+    }
+    if (numCols > 0) {
+        if (firstCol + numCols > ncol) stop("cols exceeds the columns of " + varname + "!");
+        return make_altrep_matrix(const_cast<double*>(data) + firstCol * nrow, nrow, numCols);
+    }
+    return make_altrep_matrix(const_cast<double*>(data), nrow, ncol);
+}
+
+List retrieveViews(std::string name_space, CharacterVector vars, SEXP cols, bool copyOnWrite) {
 #ifdef _WIN32
     // For windows we prepend the namespace identifier by "Local\\" because otherwise the shared memory is shared system-wide (instead of user-wide) which needs admin privileges
     name_space = "Local\\" + name_space;   
@@ -15,22 +36,52 @@ List retrieveViews(std::string name_space, CharacterVector vars) {
         return List::create();
     }
 
+    // a window of columns, 0-based
+    size_t firstCol = 0, numCols = 0;
+    if (!Rf_isNull(cols)) {
+        IntegerVector range(cols);
+        if (range.size() != 2 || range[0] == NA_INTEGER || range[1] == NA_INTEGER || range[0] < 1 || range[1] < range[0]) {
+            stop("cols has to be a range c(first, last) of columns!");
+        }
+        firstCol = static_cast<size_t>(range[0] - 1);
+        numCols = static_cast<size_t>(range[1] - range[0] + 1);
+    }
+
     List result(vars.size());
+    bool arena = arena_present(name_space);
 
     for (int i = 0; i < vars.size(); ++i) {
         std::string varname = Rcpp::as<std::string>(vars[i]);
 
-        // open a viewership page to the variable
-        auto view = viewPage(name_space + "." + varname, name_space + ".md." + varname);
+        // variables in the arena of the namespace need no mapping of their own
+        if (arena) {
+            SEXP packed = retrieveArenaView(name_space, varname, firstCol, numCols);
+            if (!Rf_isNull(packed)) {
+                result[i] = packed;
+                continue;
+            }
+        }
+
+        // open a viewership page to the variable (or a window of it)
+        bool hadView = hasView(name_space + "." + varname);
+        auto view = viewPage(name_space + "." + varname, name_space + ".md." + varname, firstCol, numCols, copyOnWrite);
         metadata::type data_type = view->metaPtr()->data_type;
 
-        // wrap the page into an ALTREP
+        // wrap the page into an ALTREP; the column statistics do not describe the private changes of a copy-on-write view
+        const ColumnStats* stats = view->copyOnWrite() ? nullptr : view->columnStats();
+        PageSource source = view->dataSource();
         if (data_type == metadata::type::MATRIX) {
-            result[i] = make_altrep_matrix(view->memPtr(), view->metaPtr()->matrix_data.nrow, view->metaPtr()->matrix_data.ncol);
+            size_t ncol = view->windowCols() > 0 ? view->windowCols() : view->metaPtr()->matrix_data.ncol;
+            result[i] = make_altrep_matrix(view->memPtr(), view->metaPtr()->matrix_data.nrow, ncol, view->copyOnWrite(),
+                                           stats, view->header(), &source);
         } else if (data_type == metadata::type::VECTOR) {
-            result[i] = make_altrep_vector(view->memPtr(), view->metaPtr()->vector_data.n);
+            result[i] = make_altrep_vector(view->memPtr(), view->metaPtr()->vector_data.n, view->copyOnWrite(), stats, view->header(),
+                                           &source);
         } else if (data_type == metadata::type::LIST) {
-            result[i] = make_altrep_list(view->metaPtr(), view->memPtr());
+            result[i] = make_altrep_list(view->metaPtr(), view->memPtr(), view->copyOnWrite(), &source);
+        } else if (data_type == metadata::type::CODES) {
+            if (!hadView) releaseView(name_space + "." + varname);
+            stop("Variable '" + varname + "' holds the grid codes of mutualinfoMatrix, which cannot be viewed!");
         } else {
             stop("Unknown Datatype!");
         }
@@ -40,32 +91,144 @@ List retrieveViews(std::string name_space, CharacterVector vars) {
     return result;
 }
 
+// the finalizer of the handle of a tile: drops its reference to the view of the matrix
+static void release_tile_view(SEXP handle) {
+    delete static_cast<std::shared_ptr<SharedData>*>(R_ExternalPtrAddr(handle));
+    R_ClearExternalPtr(handle);
+}
+
+SEXP retrieveTile(std::string name_space, std::string varname, IntegerVector rows, IntegerVector cols) {
+#ifdef _WIN32
+    // For windows we prepend the namespace identifier by "Local\\" because otherwise the shared memory is shared system-wide (instead of user-wide) which needs admin privileges
+    name_space = "Local\\" + name_space;
+#endif
+    // the whole matrix is viewed once, every tile points into it and holds the view, so that releaseViews does not
+    // unmap it under a tile that is still in use (e.g. a result of memTileApply)
+    double* data = nullptr;
+    size_t nrow = 0, ncol = 0;
+    bool isMatrix = false, attached = false;
+    std::shared_ptr<SharedData> view;
+    std::string name = name_space + "." + varname;
+    bool hadView = hasView(name);
+    const double* packed = arena_present(name_space) ? arena_view(name_space, varname, isMatrix, nrow, ncol, attached) : nullptr;
+    if (packed != nullptr) {
+        data = const_cast<double*>(packed);
+    } else {
+        view = viewPage(name, name_space + ".md." + varname);
+        isMatrix = view->metaPtr()->data_type == metadata::type::MATRIX;
+        if (isMatrix) {
+            nrow = view->metaPtr()->matrix_data.nrow;
+            ncol = view->metaPtr()->matrix_data.ncol;
+        }
+        data = view->memPtr();
+    }
+    try {
+        if (!isMatrix) stop("Tiles can only be retrieved from matrices, '" + varname + "' is none!");
+        if (rows.size() != 2 || cols.size() != 2 || rows[0] == NA_INTEGER || rows[1] == NA_INTEGER || cols[0] == NA_INTEGER ||
+            cols[1] == NA_INTEGER || rows[0] < 1 || rows[1] < rows[0] || cols[0] < 1 || cols[1] < cols[0] ||
+            static_cast<size_t>(rows[1]) > nrow || static_cast<size_t>(cols[1]) > ncol) {
+            stop("The tile exceeds the %d x %d matrix '%s'!", static_cast<int>(nrow), static_cast<int>(ncol), varname);
+        }
+    } catch (...) {
+        // drop what this call attached, a rejected tile holds no view
+        if (packed != nullptr) {
+            if (attached) arena_release_view(name_space, varname);
+        } else if (!hadView) {
+            view.reset();
+            releaseView(name);
+        }
+        throw;
+    }
+    if (attached) catalog_attach(name_space, varname, 1);
+    size_t firstRow = static_cast<size_t>(rows[0] - 1), firstCol = static_cast<size_t>(cols[0] - 1);
+    SEXP handle = R_NilValue;
+    if (view) {
+        handle = PROTECT(R_MakeExternalPtr(new std::shared_ptr<SharedData>(view), R_NilValue, R_NilValue));
+        R_RegisterCFinalizerEx(handle, release_tile_view, TRUE);
+    } else {
+        PROTECT(handle);
+    }
+    SEXP tile = PROTECT(make_altrep_tile(data + firstCol * nrow + firstRow, static_cast<size_t>(rows[1] - rows[0] + 1),
+                                         static_cast<size_t>(cols[1] - cols[0] + 1), nrow, handle));
+    // the arena is unmapped with its last view, its variables are small: their tiles are copied right away
+    if (!view) altrep_tile_dataptr(tile, FALSE);
+    UNPROTECT(2);
+    return tile;
+}
+
+// the column statistics of a page as a data.frame with one row per column
+static DataFrame statsFrame(const ColumnStats* stats, size_t ncol) {
+    NumericVector sum(ncol), mean(ncol), sd(ncol), min(ncol), max(ncol), na(ncol);
+    for (size_t j = 0; j < ncol; j++) {
+        sum[j] = stats[j].sum;
+        mean[j] = stats[j].mean;
+        sd[j] = stats[j].sd;
+        min[j] = stats[j].min;
+        max[j] = stats[j].max;
+        na[j] = static_cast<double>(stats[j].na_count);
+    }
+    return DataFrame::create(Named("sum") = sum, Named("mean") = mean, Named("sd") = sd, Named("min") = min,
+                             Named("max") = max, Named("na") = na);
+}
+
+// the types and sizes of the elements of a list as a data.frame with one row per element; a vector is one column
+static DataFrame elementsFrame(const metadata* m, size_t n) {
+    CharacterVector type(n);
+    NumericVector nrow(n), ncol(n), bytes(n);
+    for (size_t i = 0; i < n; i++) {
+        bool isMatrix = m[i].data_type == metadata::type::MATRIX;
+        type[i] = isMatrix ? "matrix" : "vector";
+        nrow[i] = static_cast<double>(isMatrix ? m[i].matrix_data.nrow : m[i].vector_data.n);
+        ncol[i] = static_cast<double>(isMatrix ? m[i].matrix_data.ncol : 1);
+        bytes[i] = nrow[i] * ncol[i] * sizeof(double);
+    }
+    return DataFrame::create(Named("type") = type, Named("nrow") = nrow, Named("ncol") = ncol, Named("bytes") = bytes,
+                             Named("stringsAsFactors") = false);
+}
+
 List retrieveMetadata(std::string name_space, std::string varname) {
 #ifdef _WIN32
     // For windows we prepend the namespace identifier by "Local\\" because otherwise the shared memory is shared system-wide (instead of user-wide) which needs admin privileges
     name_space = "Local\\" + name_space;   
 #endif
+    bool isMatrix = false, attached = false;
+    size_t nrow = 0, ncol = 0;
+    if (arena_present(name_space) && arena_view(name_space, varname, isMatrix, nrow, ncol, attached) != nullptr) {
+        if (attached) catalog_attach(name_space, varname, 1);
+        if (isMatrix) {
+            return List::create(Named("type") = "matrix", Named("nrow") = nrow, Named("ncol") = ncol);
+        }
+        return List::create(Named("type") = "vector", Named("n") = nrow);
+    }
+
     // retrieve a viewership page of the variable
     auto view = viewPage(name_space + "." + varname, name_space + ".md." + varname);
     metadata::type data_type = view->metaPtr()->data_type;
 
     // wrap the metadata of the viewership page into a list.
     if (data_type == metadata::type::MATRIX) {
-        return List::create(
+        List result = List::create(
             Named("type") = "matrix",
             Named("nrow") = view->metaPtr()->matrix_data.nrow,
             Named("ncol") = view->metaPtr()->matrix_data.ncol
         );
+        if (view->columnStats() != nullptr) result["stats"] = statsFrame(view->columnStats(), view->metaPtr()->matrix_data.ncol);
+        return result;
     } else if (data_type == metadata::type::VECTOR) {
-        return List::create(
+        List result = List::create(
             Named("type") = "vector",
             Named("n") = view->metaPtr()->vector_data.n
         );
+        if (view->columnStats() != nullptr) result["stats"] = statsFrame(view->columnStats(), 1);
+        return result;
     } else if (data_type == metadata::type::LIST) {
         return List::create(
             Named("type") = "list",
-            Named("n") = view->metaPtr()->list_data.n
+            Named("n") = view->metaPtr()->list_data.n,
+            Named("elements") = elementsFrame(view->metaPtr() + 1, view->metaPtr()->list_data.n)
         );
+    } else if (data_type == metadata::type::CODES) {
+        return List::create(Named("type") = "codes");
     } else {
         stop("Unknown type '%s' for variable '%s'", data_type, varname);
     }
@@ -78,23 +241,34 @@ void releaseViews(std::string name_space, CharacterVector vars) {
     for (long int i = 0; i < vars.size(); ++i) {
         std::string varname = Rcpp::as<std::string>(vars[i]);
 
+        if (arena_release_view(name_space, varname)) {
+            catalog_attach(name_space, varname, -1);
+            continue;
+        }
         releaseView(name_space + "." + varname);
     }
 }
 List viewList() {
     std::vector<std::string> viewNames = getSharedViews();
+    std::vector<std::string> arenaNames = arena_views();
+    viewNames.insert(viewNames.end(), arenaNames.begin(), arenaNames.end());
     List result(viewNames.size());
     for (std::size_t i = 0; i < viewNames.size(); i++)
         result[i] = viewNames[i];
     return result;
 }
 
-extern "C" SEXP C_retrieveViews(SEXP name_spaceSEXP, SEXP varsSEXP) {
+DataFrame viewStats() {
+    return getSharedStats(false);
+}
+
+extern "C" SEXP C_retrieveViews(SEXP name_spaceSEXP, SEXP varsSEXP, SEXP colsSEXP, SEXP copyOnWriteSEXP) {
     try {
         std::string name_space = as<std::string>(name_spaceSEXP);
         CharacterVector vars = as<CharacterVector>(varsSEXP);
+        bool copyOnWrite = as<bool>(copyOnWriteSEXP);
 
-        List result = retrieveViews(name_space, vars);
+        List result = retrieveViews(name_space, vars, colsSEXP, copyOnWrite);
         return result;
     } catch (std::exception &e) {
         Rf_error("retrieveViews error: %s", e.what());
@@ -102,6 +276,16 @@ extern "C" SEXP C_retrieveViews(SEXP name_spaceSEXP, SEXP varsSEXP) {
         Rf_error("retrieveViews unknown error");
     }
 }
+extern "C" SEXP C_retrieveTile(SEXP name_spaceSEXP, SEXP varnameSEXP, SEXP rowsSEXP, SEXP colsSEXP) {
+    try {
+        return retrieveTile(as<std::string>(name_spaceSEXP), as<std::string>(varnameSEXP), as<IntegerVector>(rowsSEXP),
+                            as<IntegerVector>(colsSEXP));
+    } catch (std::exception &e) {
+        Rf_error("retrieveTile error: %s", e.what());
+    } catch (...) {
+        Rf_error("retrieveTile unknown error");
+    }
+}
 extern "C" SEXP C_retrieveMetadata(SEXP name_spaceSEXP, SEXP varnameSEXP) {
     try {
         std::string name_space = as<std::string>(name_spaceSEXP);
@@ -132,3 +316,12 @@ extern "C" SEXP C_releaseViews(SEXP name_spaceSEXP, SEXP varsSEXP) {
 extern "C" SEXP C_viewList() {
     return viewList();
 }
+extern "C" SEXP C_viewStats() {
+    try {
+        return viewStats();
+    } catch (std::exception &e) {
+        Rf_error("viewStats error: %s", e.what());
+    } catch (...) {
+        Rf_error("viewStats unknown error");
+    }
+}
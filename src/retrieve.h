@@ -9,10 +9,27 @@ using namespace Rcpp;
  * 
  * @param name_space        A string identifying the memory space we are working in.
  * @param vars              A character vector (R-equivalent of std::vector<std::string>) containing the variable names inside the memory space that should be retrieved to R.
+ * @param cols              NULL or c(first, last) (1-based): only these columns of the matrices are mapped and retrieved
+ *                          as a matrix of last - first + 1 columns; see viewPage.
+ * @param copyOnWrite       Map the variables privately so that they can be modified in place without affecting other
+ *                          processes; see viewPage. Variables in an arena are duplicated on the first write instead.
  * 
  * @result  An R list of ALTREP representations of the shared objects (double matrices, double vectors, or lists of these).
  */
-List retrieveViews(std::string name_space, CharacterVector vars);
+List retrieveViews(std::string name_space, CharacterVector vars, SEXP cols, bool copyOnWrite);
+
+/**
+ * Retrieves a tile (a block of rows and columns) of a shared matrix as an ALTREP that reads the elements from the
+ * view of the matrix without copying them; see make_altrep_tile. The view is released by releaseViews, but stays
+ * mapped until the last tile of it is gone. Tiles of matrices in an arena are copied.
+ * 
+ * @param name_space        A string identifying the memory space we are working in.
+ * @param varname           The name of the matrix.
+ * @param rows, cols        The ranges c(first, last) (1-based) of the tile.
+ * 
+ * @result  The tile as a matrix of last - first + 1 rows and columns.
+ */
+SEXP retrieveTile(std::string name_space, std::string varname, IntegerVector rows, IntegerVector cols);
 
 /**
  * Retrieves a type-specific, named list containing the metadata for an object.
@@ -42,6 +59,13 @@ void releaseViews(std::string name_space, CharacterVector vars);
  */
 List viewList();
 
+/**
+ * Retrieves the statistics (sizes, attach timings and counters, ...) of the variables currently viewed by the current process.
+ * 
+ * @result  data.frame with one row per variable.
+ */
+DataFrame viewStats();
+
 
 
 
@@ -55,10 +79,17 @@ List viewList();
  * 
  * @param name_spaceSEXP        A character (R-string) identifying the memory space we are working in.
  * @param varsSEXP              A character vector (R-equivalent of std::vector<std::string>) containing the variable names inside the memory space that should be retrieved to R.
+ * @param colsSEXP              NULL or an integer range c(first, last) of the matrix columns to retrieve.
+ * @param copyOnWriteSEXP       A logical whether to retrieve copy-on-write views.
  * 
  * @result  An R list of ALTREP representations of the shared objects (double matrices, double vectors, or lists of these).
  */
-extern "C" SEXP C_retrieveViews(SEXP name_spaceSEXP, SEXP varsSEXP);
+extern "C" SEXP C_retrieveViews(SEXP name_spaceSEXP, SEXP varsSEXP, SEXP colsSEXP, SEXP copyOnWriteSEXP);
+
+/**
+ * Wrapper function for retrieveTile above.
+ */
+extern "C" SEXP C_retrieveTile(SEXP name_spaceSEXP, SEXP varnameSEXP, SEXP rowsSEXP, SEXP colsSEXP);
 
 /**
  * Wrapper function for retrieveMetadata above. It retrieves a type-specific, named list containing the metadata for an object.
@@ -88,3 +119,8 @@ extern "C" SEXP C_releaseViews(SEXP name_spaceSEXP, SEXP varsSEXP);
  * Wrapper function for viewList above. It retrieves a list of the variables currently held in viewership of the current process.
  */
 extern "C" SEXP C_viewList();
+
+/**
+ * Wrapper function for viewStats above.
+ */
+extern "C" SEXP C_viewStats();
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef> // size_t
+#include <cstdint>
+#include <stdexcept>
+#include <thread>
+
+/**
+ * Every metadata page starts with a SegmentHeader followed by the metadata of the object (see metadata.h).
+ *
+ * The header holds the bookkeeping that spans processes: the sizes of both pages, the time the owner spent in
+ * registering the object and the counters of the viewers. The magic marks the page as a memshare page as soon as
+ * it is created, complete is only set when its data was written (see registerPagesAsync). Viewers map the metadata page writable so that they can
+ * update the atomic counters; the data page stays read-only for them.
+ *
+ * The atomics are lock-free for 64 bit integers on all supported platforms and hence address-free, i.e. they
+ * work across processes mapping the same page.
+ */
+
+// "MEMSHARE" in ASCII; marks a fully initialized metadata page
+const std::uint64_t SEGMENT_MAGIC = 0x4d454d5348415245ULL;
+const std::uint32_t SEGMENT_VERSION = 6;
+const std::size_t SEGMENT_NAME_BYTES = 112;
+const std::size_t SEGMENT_PATH_BYTES = 1024;
+
+struct SegmentHeader {
+    std::uint64_t magic;
+    std::uint32_t version;
+    std::atomic<std::uint32_t> complete;       // set once the data page is filled; viewers refuse incomplete pages
+    std::uint64_t meta_bytes;                  // size of the metadata page including this header
+    std::uint64_t data_bytes;                  // size of the data page
+    std::int64_t created;                      // registration time in microseconds since the epoch
+    double alloc_secs;                         // time the owner spent in creating and mapping the pages
+    double memcpy_secs;                        // time the owner spent in filling the data page
+    std::atomic<std::uint64_t> attach_count;   // number of views attached so far
+    std::atomic<std::int64_t> active_views;    // number of views currently attached
+    std::atomic<std::int64_t> last_access;     // time of the last registration/retrieval in microseconds since the epoch
+    std::int64_t owner_pid;                    // the lease of the owner: its process id and the start time of its
+    std::uint64_t owner_start;                 // process (see reclaim.h)
+    char data_name[SEGMENT_NAME_BYTES];        // name of the data page, zero-terminated; empty if it is too long
+    char backing_path[SEGMENT_PATH_BYTES];     // file the data page is mapped from (see restoreNamespace); empty for shared memory
+    std::atomic<std::uint64_t> sequence;       // seqlock of in-place updates of the data page: odd while one is written
+    std::uint64_t stats_offset;                // offset of the column statistics in the metadata page (see column_stats.h)
+    std::uint64_t stats_columns;               // their number, 0 if none were computed
+    std::atomic<std::uint32_t> stats_valid;    // cleared by in-place updates, which make the statistics stale
+};
+
+// the metadata starts at this offset of the metadata page; leaves room for the header to grow
+const std::size_t SEGMENT_HEADER_BYTES = 2048;
+static_assert(sizeof(SegmentHeader) <= SEGMENT_HEADER_BYTES, "SegmentHeader exceeds its reserved space");
+
+/**
+ * Current wall clock time in microseconds since the epoch.
+ */
+inline std::int64_t segment_now() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * Seqlock of the data page: the owner brackets every in-place update by segment_write_begin/end (there is only one
+ * writer, the owner). A reader takes the sequence via segment_read_begin, copies the data and retries if
+ * segment_read_retry tells that an update interfered.
+ */
+inline void segment_write_begin(SegmentHeader* h) {
+    h->sequence.store(h->sequence.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+}
+
+inline void segment_write_end(SegmentHeader* h) {
+    h->sequence.store(h->sequence.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+/**
+ * Waits until no update is in progress and returns the sequence.
+ *
+ * @param timeoutSecs     An update still in progress after this time (i.e. its writer died) is an error.
+ */
+inline std::uint64_t segment_read_begin(const SegmentHeader* h, double timeoutSecs = 10) {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (;;) {
+        std::uint64_t seq = h->sequence.load(std::memory_order_acquire);
+        if (seq % 2 == 0) return seq;
+        if (std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() > timeoutSecs) {
+            throw std::runtime_error("An update of the variable did not finish in time; its owner might have died.");
+        }
+        std::this_thread::yield();
+    }
+}
+
+inline bool segment_read_retry(const SegmentHeader* h, std::uint64_t seq) {
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return h->sequence.load(std::memory_order_relaxed) != seq;
+}
+
+/**
+ * A published variable (see publishPage) lives in a series of generations, each a pair of ordinary pages whose names
+ * carry the suffix "@<generation>". The control page (named namespace + ".ver." + variable) holds the current
+ * generation; the owner flips it once a new generation is filled, viewers resolve the variable through it.
+ */
+
+// "MEMVERS1" in ASCII; marks an initialized control page
+const std::uint64_t VERSION_MAGIC = 0x4d454d5645525331ULL;
+
+struct VersionControl {
+    std::atomic<std::uint64_t> magic;          // written last by the creator
+    std::atomic<std::uint64_t> generation;     // the current generation, 0 before the first one is published
+    std::atomic<std::uint32_t> retired;        // set before the page is removed; holders have to reopen it
+    std::uint32_t reserved;
+    std::int64_t owner_pid;                    // the lease of the owner (see reclaim.h)
+    std::uint64_t owner_start;
+};
+
+const std::size_t VERSION_CONTROL_BYTES = 64;
+static_assert(sizeof(VersionControl) <= VERSION_CONTROL_BYTES, "VersionControl exceeds its reserved space");
@@ -1,154 +1,834 @@
 #include "shared_memory.h"
+#include "arena.h"
+#include "catalog.h"
+#include "reclaim.h"
+#include "parallel.h"
+#include "pool.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
 #include <iostream>
+#include <mutex>
+#include <new>
+#include <thread>
+
+#ifndef _WIN32
+#include <sys/resource.h> // getrusage
+#endif
 
 std::map<std::string, std::shared_ptr<SharedData>> views;
 std::map<std::string, std::unique_ptr<SharedData>> pages;
 
-void SharedData::alloc(const std::string& shared_mem_name, const std::string& shared_meta_name, SEXP obj) {
+// the control pages of published variables mapped by this process, by data page name (see publishPage)
+static std::map<std::string, std::unique_ptr<MemoryPage>> controls;
+
+// quotas by namespace, "" is the global quota
+static std::map<std::string, std::uint64_t> quotas;
+static std::mutex quotaMutex;
+
+/**
+ * An asynchronous registration (see registerPagesAsync). The worker thread only touches plans, results, error and
+ * done; the job itself is created and destroyed on the main thread.
+ */
+struct AsyncJob {
+    std::vector<std::string> names, metanames;
+    std::vector<CopyPlan> plans;
+    std::vector<std::unique_ptr<SharedData>> results;   // the pages registered so far
+    std::string error;                                  // the first error; empty on success
+    std::atomic<bool> done{false};
+    SEXP objs = R_NilValue;                             // preserved until the job is reaped
+    std::thread worker;
+
+    ~AsyncJob() {
+        if (worker.joinable()) worker.join();
+    }
+};
+static std::map<int, std::unique_ptr<AsyncJob>> asyncJobs;
+static int nextAsyncJob = 1;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double seconds_since(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+// minor and major page faults of this process so far; -1 where not available
+void sample_faults(long& minor, long& major) {
+#ifdef _WIN32
+    minor = -1;
+    major = -1;
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0) {
+        minor = usage.ru_minflt;
+        major = usage.ru_majflt;
+    } else {
+        minor = -1;
+        major = -1;
+    }
+#endif
+}
+
+// the fault counters accumulated since (minor0, major0)
+void fault_delta(long minor0, long major0, PageStats& stats) {
+    long minor1, major1;
+    sample_faults(minor1, major1);
+    if (minor0 >= 0 && minor1 >= 0) {
+        stats.minor_faults = minor1 - minor0;
+        stats.major_faults = major1 - major0;
+    }
+}
+
+// the length of a variable or page name without its generation suffix "@<digits>" (see publishPage)
+size_t generation_base(const std::string& name) {
+    size_t at = name.rfind('@');
+    if (at == std::string::npos || at + 1 == name.size()) return name.size();
+    for (size_t k = at + 1; k < name.size(); k++) {
+        if (name[k] < '0' || name[k] > '9') return name.size();
+    }
+    return at;
+}
+
+// the page name of a generation of a published variable
+std::string generation_name(const std::string& name, std::uint64_t generation) {
+    return name + "@" + std::to_string(generation);
+}
+
+// split a page name "namespace.var" into its parts given the metadata page name "namespace.md.var"; the generation
+// suffix of a published variable is not part of the variable name
+void split_page_name(const std::string& name, const std::string& metaname, std::string& name_space, std::string& varname) {
+    name_space.clear();
+    varname.clear();
+    if (metaname.size() != name.size() + 3) return;
+    for (size_t k = 0; k < name.size(); k++) {
+        if (name[k] == '.' && metaname.compare(0, k, name, 0, k) == 0 && metaname.compare(k, 4, ".md.") == 0 &&
+            metaname.compare(k + 4, std::string::npos, name, k + 1, std::string::npos) == 0) {
+            name_space = name.substr(0, k);
+            varname = name.substr(k + 1);
+            varname.resize(generation_base(varname));
+            return;
+        }
+    }
+}
+
+VersionControl* control_of(MemoryPage* page) {
+    return static_cast<VersionControl*>(static_cast<void*>(page->data()));
+}
+
+/**
+ * The control page of a published variable mapped into this process or nullptr if the variable is not published
+ * (and create is not set). Control pages retired by their owner are reopened.
+ */
+VersionControl* version_control(const std::string& name, const std::string& metaname, bool create) {
+    auto it = controls.find(name);
+    if (it != controls.end()) {
+        VersionControl* c = control_of(it->second.get());
+        if (!c->retired.load()) return c;
+        controls.erase(it);
+    }
+    std::string name_space, varname;
+    split_page_name(name, metaname, name_space, varname);
+    if (name_space.empty()) return nullptr;
+
+    auto page = std::make_unique<MemoryPage>();
+    bool created;
     try {
-        // differentiate by the type of the object and conditionally on it initialize a metadata object, a memory page of the appropriate size and fill the memory.
-        if (Rf_isMatrix(obj) && TYPEOF(obj) == REALSXP) {
-            NumericMatrix mat(obj);
-            // make the metadata
-            metadata m = make_matrix_metadata(mat.nrow(), mat.ncol());
-            meta = std::make_unique<MemoryPage>();
-            meta->alloc(shared_meta_name, sizeof(metadata));
-            // make the memory page
-            mem = std::make_unique<MemoryPage>();
-            mem->alloc(shared_mem_name, m.matrix_data.nrow * m.matrix_data.ncol * sizeof(double));
-
-            // fill the data
-            std::memcpy(meta->data(), &m, sizeof(metadata));
-            std::memcpy(mem->data(), mat.begin(), m.matrix_data.nrow * m.matrix_data.ncol * sizeof(double));
-        } else if (Rf_isVector(obj) && TYPEOF(obj) == REALSXP) {
-            NumericVector vec(obj);
-            // make the metadata
-            metadata m = make_vector_metadata(vec.size());
-            meta = std::make_unique<MemoryPage>();
-            meta->alloc(shared_meta_name, sizeof(metadata));
-            // make the memory page
-            mem = std::make_unique<MemoryPage>();
-            mem->alloc(shared_mem_name, m.vector_data.n * sizeof(double));
-
-            // fill the data
-            std::memcpy(meta->data(), &m, sizeof(metadata));
-            std::memcpy(mem->data(), vec.begin(), m.vector_data.n * sizeof(double));
-        } else if (Rf_isNewList(obj)) {
-            List l(obj);
-            // make the metadata
-            std::vector<metadata> m = make_list_metadata(l);
-            size_t total_elements = 0;
-            for (size_t i = 1; i < m.size(); i++) {
-                if (m[i].data_type == metadata::type::MATRIX) {
-                    total_elements += m[i].matrix_data.nrow * m[i].matrix_data.ncol;
-                } else if (m[i].data_type == metadata::type::VECTOR) {
-                    total_elements += m[i].vector_data.n;
-                } else if (m[i].data_type == metadata::type::LIST) {
-                    stop("Nested Lists are not supported yet!");
-                } else {
-                    stop("Unknown element type in List!");
-                }
-            }
+        created = page->open(name_space + ".ver." + varname, VERSION_CONTROL_BYTES, create);
+    } catch (std::runtime_error&) {
+        if (!create) return nullptr;
+        throw;
+    }
+    VersionControl* c = control_of(page.get());
+    if (created) {
+        c->owner_pid = current_pid();
+        c->owner_start = process_start_time(c->owner_pid);
+        c->magic.store(VERSION_MAGIC);
+    } else if (c->magic.load() != VERSION_MAGIC || c->retired.load()) {
+        // still being created or already being removed, there is no generation to view
+        return nullptr;
+    }
+    controls[name] = std::move(page);
+    return c;
+}
 
-            m[0].list_data.numDoubles = total_elements;
-
-            meta = std::make_unique<MemoryPage>();
-            meta->alloc(shared_meta_name, sizeof(metadata) * m.size());
-            // make the memory page
-            mem = std::make_unique<MemoryPage>();
-            mem->alloc(shared_mem_name, l.size() * sizeof(unsigned long long) + total_elements * sizeof(double));
-            
-            // fill it
-            std::memcpy(meta->data(), m.data(), m.size() * sizeof(metadata));
-
-            // reserve first m.size() - 1 many pointer-sized entries for the locations of the data in the memory chunk.
-            unsigned long long curr = 0;
-            double* start = static_cast<double*>(static_cast<void*>(static_cast<unsigned long long*>(static_cast<void*>(mem->data())) + l.size()));
-            for (int i = 0; i < l.size(); i++) {
-                *(static_cast<unsigned long long*>(static_cast<void*>(mem->data())) + i) = curr;
-                if (m[i+1].data_type == metadata::type::MATRIX) {
-                    NumericMatrix mat = as<NumericMatrix>(l[i]);
-                    unsigned long long size = m[i+1].matrix_data.nrow * (unsigned long long) m[i+1].matrix_data.ncol;
-                    std::memcpy(start + curr, mat.begin(), size * sizeof(double));
-                    curr += size;
-                } else if (m[i+1].data_type == metadata::type::VECTOR) {
-                    NumericVector vec = as<NumericVector>(l[i]);
-                    unsigned long long size = m[i+1].vector_data.n;
-                    std::memcpy(start + curr, vec.begin(), size * sizeof(double));
-                    curr += size;
-                }
+// remove the control page of a published variable owned by this process; viewers holding it reopen it
+void retire_control(const std::string& name) {
+    auto it = controls.find(name);
+    if (it == controls.end()) return;
+    control_of(it->second.get())->retired.store(1);
+    MemoryPage::unlink(it->second->get_name());
+    controls.erase(it);
+}
+
+const std::string COPY_ON_WRITE_SUFFIX = "(cow)";
+
+// the key of a window of columns in views, the columns are 1-based as in R; private views carry a suffix
+std::string window_key(const std::string& name, size_t firstCol, size_t numCols, bool copyOnWrite) {
+    std::string key = name;
+    if (numCols > 0) key += "[" + std::to_string(firstCol + 1) + ":" + std::to_string(firstCol + numCols) + "]";
+    if (copyOnWrite) key += COPY_ON_WRITE_SUFFIX;
+    return key;
+}
+
+// the length of a key of views without the private, window and generation suffixes, i.e. of the page it views
+size_t view_base(const std::string& key) {
+    std::string base = key;
+    if (base.size() > COPY_ON_WRITE_SUFFIX.size() &&
+        base.compare(base.size() - COPY_ON_WRITE_SUFFIX.size(), COPY_ON_WRITE_SUFFIX.size(), COPY_ON_WRITE_SUFFIX) == 0) {
+        base.resize(base.size() - COPY_ON_WRITE_SUFFIX.size());
+    }
+    if (!base.empty() && base.back() == ']') {
+        size_t open = base.rfind('[');
+        if (open != std::string::npos) base.resize(open);
+    }
+    return generation_base(base);
+}
+
+// the keys of views holding name: the page itself, its windows and the generations of a published variable
+std::vector<std::string> view_keys(const std::string& name) {
+    std::vector<std::string> keys;
+    for (auto it = views.lower_bound(name); it != views.end() && it->first.compare(0, name.size(), name) == 0; ++it) {
+        if (view_base(it->first) == name.size()) keys.push_back(it->first);
+    }
+    return keys;
+}
+
+// the total size of the pages owned by this process
+std::uint64_t owned_bytes() {
+    std::uint64_t used = 0;
+    for (auto const& p : pages) used += p.second->header()->data_bytes + p.second->header()->meta_bytes;
+    return used;
+}
+
+}
+
+void SharedData::alloc_pages(const std::string& shared_mem_name, const std::string& shared_meta_name, const metadata* m,
+                             size_t nmeta, size_t dataBytes, bool populate, bool checkQuota, size_t statsColumns) {
+    split_page_name(shared_mem_name, shared_meta_name, name_space, varname);
+    size_t statsOffset = SEGMENT_HEADER_BYTES + nmeta * sizeof(metadata);
+    size_t metaBytes = statsOffset + statsColumns * sizeof(ColumnStats);
+    if (checkQuota) checkPageQuota(name_space, metaBytes + dataBytes);
+
+    Clock::time_point start = Clock::now();
+    meta = std::make_unique<MemoryPage>();
+    meta->alloc(shared_meta_name, metaBytes);
+    // small data pages come from the pool (see pool.h), larger ones carry the name of the variable
+    mem = pool_take(dataBytes, populate, recycled);
+    if (!mem) {
+        mem = std::make_unique<MemoryPage>();
+        mem->alloc(shared_mem_name, dataBytes, populate);
+    }
+    stats.mmap_secs = seconds_since(start);
+
+    // the fresh page is zero-filled, value-initialization keeps the atomics at zero
+    SegmentHeader* h = new (meta->data()) SegmentHeader();
+    h->version = SEGMENT_VERSION;
+    h->meta_bytes = metaBytes;
+    h->data_bytes = dataBytes;
+    h->created = segment_now();
+    h->alloc_secs = stats.mmap_secs;
+    h->last_access.store(h->created);
+    h->owner_pid = current_pid();
+    h->owner_start = process_start_time(h->owner_pid);
+    h->stats_offset = statsOffset;
+    h->stats_columns = statsColumns;
+    std::string dataName = mem->get_name();
+    if (dataName.size() < SEGMENT_NAME_BYTES) {
+        std::memcpy(h->data_name, dataName.c_str(), dataName.size());
+    }
+    std::memcpy(metaPtr(), m, nmeta * sizeof(metadata));
+    h->magic = SEGMENT_MAGIC;
+}
+
+CopyPlan plan_copy(SEXP obj) {
+    CopyPlan plan;
+    // differentiate by the type of the object and conditionally on it initialize the metadata and the sources of the data.
+    if (Rf_isMatrix(obj) && TYPEOF(obj) == REALSXP) {
+        NumericMatrix mat(obj);
+        plan.meta.push_back(make_matrix_metadata(mat.nrow(), mat.ncol()));
+        plan.sources.push_back({mat.begin(), plan.meta[0].matrix_data.nrow * plan.meta[0].matrix_data.ncol});
+    } else if (Rf_isVector(obj) && TYPEOF(obj) == REALSXP) {
+        NumericVector vec(obj);
+        plan.meta.push_back(make_vector_metadata(vec.size()));
+        plan.sources.push_back({vec.begin(), plan.meta[0].vector_data.n});
+    } else if (Rf_isNewList(obj)) {
+        List l(obj);
+        plan.meta = make_list_metadata(l);
+        size_t total_elements = 0;
+        for (size_t i = 1; i < plan.meta.size(); i++) {
+            const metadata& m = plan.meta[i];
+            if (m.data_type == metadata::type::MATRIX) {
+                plan.sources.push_back({REAL(l[i - 1]), m.matrix_data.nrow * m.matrix_data.ncol});
+            } else if (m.data_type == metadata::type::VECTOR) {
+                plan.sources.push_back({REAL(l[i - 1]), m.vector_data.n});
+            } else if (m.data_type == metadata::type::LIST) {
+                stop("Nested Lists are not supported yet!");
+            } else {
+                stop("Unknown element type in List!");
             }
-        } else {
-            stop("Unsupported shared memory type.");
+            total_elements += plan.sources.back().second;
         }
+        plan.meta[0].list_data.numDoubles = total_elements;
+        // reserve the first n many pointer-sized entries for the locations of the elements in the memory chunk.
+        plan.dataBytes = l.size() * sizeof(unsigned long long);
+    } else {
+        stop("Unsupported shared memory type.");
+    }
+    for (auto const& s : plan.sources) {
+        plan.dataBytes += s.second * sizeof(double);
+        plan.largestBytes = std::max(plan.largestBytes, s.second * sizeof(double));
+    }
+    return plan;
+}
+
+void SharedData::fill(const std::string& shared_mem_name, const std::string& shared_meta_name, const CopyPlan& plan,
+                      int threads, bool checkQuota) {
+    long minor0, major0;
+    sample_faults(minor0, major0);
+    size_t nthreads = threads > 0 ? static_cast<size_t>(threads) : default_threads();
+    // a single thread is faster with all pages mapped up front; several threads take the page faults in parallel.
+    // The elements of a list are copied one after the other, each one in parallel if it is large.
+    bool populate = nthreads == 1 || plan.largestBytes < PARALLEL_COPY_MIN_BYTES;
+    // a placement has to be set before the pages are touched, otherwise they would be migrated
+    populate = populate && plan.placement == NUMA_DEFAULT;
+    // column statistics of a matrix (a vector is one column) are computed in the pass that copies it
+    size_t statsColumns = 0;
+    if (plan.stats && plan.meta[0].data_type == metadata::type::MATRIX) statsColumns = plan.meta[0].matrix_data.ncol;
+    if (plan.stats && plan.meta[0].data_type == metadata::type::VECTOR) statsColumns = 1;
+    alloc_pages(shared_mem_name, shared_meta_name, plan.meta.data(), plan.meta.size(), plan.dataBytes, populate, checkQuota,
+                statsColumns);
+    numa_place(mem->data(), plan.dataBytes, plan.placement);
+
+    Clock::time_point start = Clock::now();
+    if (statsColumns > 0) {
+        ColumnStats* stats = static_cast<ColumnStats*>(static_cast<void*>(reinterpret_cast<char*>(header()) + header()->stats_offset));
+        copy_column_stats(mem->data(), plan.sources[0].first, plan.sources[0].second / statsColumns, statsColumns, stats, nthreads);
+        header()->stats_valid.store(1);
+    } else if (plan.meta[0].data_type == metadata::type::LIST) {
+        unsigned long long* offsets = static_cast<unsigned long long*>(static_cast<void*>(mem->data()));
+        double* start_data = static_cast<double*>(static_cast<void*>(offsets + plan.sources.size()));
+        unsigned long long curr = 0;
+        for (size_t i = 0; i < plan.sources.size(); i++) {
+            offsets[i] = curr;
+            parallel_copy(start_data + curr, plan.sources[i].first, plan.sources[i].second * sizeof(double), nthreads);
+            curr += plan.sources[i].second;
+        }
+    } else {
+        parallel_copy(mem->data(), plan.sources[0].first, plan.sources[0].second * sizeof(double), nthreads);
+    }
+    header()->memcpy_secs = seconds_since(start);
+    fault_delta(minor0, major0, stats);
+    // viewers attach only to complete pages
+    header()->complete.store(1);
+}
+
+void SharedData::alloc(const std::string& shared_mem_name, const std::string& shared_meta_name, SEXP obj, int threads,
+                       numa_placement placement, bool stats) {
+    try {
+        CopyPlan plan = plan_copy(obj);
+        plan.placement = placement;
+        plan.stats = stats;
+        fill(shared_mem_name, shared_meta_name, plan, threads, true);
+    } catch (std::exception &e) {
+        throw std::runtime_error("Allocation error: " + std::string(e.what()));
+    }
+}
+
+double* SharedData::alloc_matrix(const std::string& shared_mem_name, const std::string& shared_meta_name, size_t nrow, size_t ncol,
+                                 metadata::type type) {
+    try {
+        long minor0, major0;
+        sample_faults(minor0, major0);
+        // a fresh shared memory section is zero-filled by the OS, only the metadata has to be written
+        metadata m = make_matrix_metadata(nrow, ncol);
+        m.data_type = type;
+        alloc_pages(shared_mem_name, shared_meta_name, &m, 1, nrow * ncol * sizeof(double));
+        if (recycled) std::memset(mem->data(), 0, nrow * ncol * sizeof(double));
+        fault_delta(minor0, major0, stats);
+        return mem->data();
     } catch (std::exception &e) {
         throw std::runtime_error("Allocation error: " + std::string(e.what()));
     }
 }
 
-void SharedData::view(const std::string& shared_mem_name, const std::string& shared_meta_name) {
+void SharedData::view(const std::string& shared_mem_name, const std::string& shared_meta_name, size_t firstCol, size_t numCols,
+                      bool copyOnWrite) {
     try {
+        long minor0, major0;
+        sample_faults(minor0, major0);
+        Clock::time_point start = Clock::now();
+
+        // map the header first to learn the sizes of both pages, then the whole metadata page
+        meta = std::make_unique<MemoryPage>();
+        meta->view(shared_meta_name, SEGMENT_HEADER_BYTES, true);
+        if (header()->magic != SEGMENT_MAGIC || header()->version != SEGMENT_VERSION) {
+            meta.reset();
+            stop("Variable '%s' was registered by an incompatible version of memshare!", shared_mem_name);
+        }
+        if (!header()->complete.load()) {
+            meta.reset();
+            stop("Variable '%s' is still being registered!", shared_mem_name);
+        }
+        size_t metaBytes = header()->meta_bytes;
+        size_t dataBytes = header()->data_bytes;
         meta = std::make_unique<MemoryPage>();
-        meta->view(shared_meta_name, sizeof(metadata));
-
-        // retrieve the metadata of the object
-        metadata* m = static_cast<metadata*>(static_cast<void*>(meta->data()));
-        metadata::type data_type = m->data_type;
-
-        // retrieve the memory page according to the metadata object
-        if (data_type == metadata::type::MATRIX) {
-            size_t nrow = m->matrix_data.nrow;
-            size_t ncol = m->matrix_data.ncol;
-            mem = std::make_unique<MemoryPage>();
-            mem->view(shared_mem_name, nrow*ncol*sizeof(double));
-        } else if (data_type == metadata::type::VECTOR) {
-            size_t n = m->vector_data.n;
-            mem = std::make_unique<MemoryPage>();
-            mem->view(shared_mem_name, n * sizeof(double));
-        } else if (data_type == metadata::type::LIST) {
-            size_t n = m->list_data.n;
-            meta = std::make_unique<MemoryPage>();
-            meta->view(shared_meta_name, (n+1) * sizeof(metadata));
-            m = static_cast<metadata*>(static_cast<void*>(meta->data()));
-
-            mem = std::make_unique<MemoryPage>();
-            mem->view(shared_mem_name, m[0].list_data.n * sizeof(unsigned long long) + m[0].list_data.numDoubles * sizeof(double));
+        meta->view(shared_meta_name, metaBytes, true);
+
+        // attach before the data page is mapped: an owner releasing the variable meanwhile either sees this view and
+        // does not recycle the data page (see dispose), or this view sees the release
+        header()->active_views.fetch_add(1);
+        is_view = true;
+        if (!header()->complete.load()) {
+            dispose();
+            stop("The requested variable was not registered!");
+        }
+
+        // a window of a matrix covers whole columns, which are contiguous in column-major order
+        size_t offset = 0;
+        if (numCols > 0) {
+            if (metaPtr()->data_type != metadata::type::MATRIX) {
+                dispose();
+                stop("Columns can only be selected for matrices, '%s' is none!", shared_mem_name);
+            }
+            size_t nrow = metaPtr()->matrix_data.nrow, ncol = metaPtr()->matrix_data.ncol;
+            if (firstCol + numCols > ncol) {
+                dispose();
+                stop("Columns %d to %d exceed the %d columns of '%s'!", firstCol + 1, firstCol + numCols, ncol, shared_mem_name);
+            }
+            offset = firstCol * nrow * sizeof(double);
+            dataBytes = numCols * nrow * sizeof(double);
+        }
+
+        // retrieve the memory page according to the header (its name differs for pooled pages); restored pages are
+        // mapped from their file
+        mem = std::make_unique<MemoryPage>();
+        std::string dataName(header()->data_name, strnlen(header()->data_name, SEGMENT_NAME_BYTES));
+        std::string backing(header()->backing_path, strnlen(header()->backing_path, SEGMENT_PATH_BYTES));
+        if (backing.empty()) {
+            mem->view(dataName.empty() ? shared_mem_name : dataName, dataBytes, false, offset, copyOnWrite);
         } else {
-            stop("Unknown type '%s' for variable '%s'", data_type, shared_mem_name);
+            mem->map_file(backing, dataBytes, false, offset, copyOnWrite);
         }
+        window_cols = numCols;
+        window_first = numCols > 0 ? firstCol : 0;
+        copy_on_write = copyOnWrite;
+        stats.mmap_secs = seconds_since(start);
+        fault_delta(minor0, major0, stats);
+
+        split_page_name(shared_mem_name, shared_meta_name, name_space, varname);
+        header()->attach_count.fetch_add(1);
+        header()->last_access.store(segment_now());
     } catch (std::runtime_error& e) {
+        dispose();
         stop("The requested variable was not registered!");
     }
 }
 
+void SharedData::snapshot(const std::string& metaPath, const std::string& dataPath) {
+    // write to temporary files first so that an interrupted snapshot never replaces a complete one
+    auto write_file = [](const std::string& path, const void* data, size_t bytes) {
+        std::string tmp = path + ".tmp";
+        {
+            std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+            if (!out) throw std::runtime_error("Could not open " + tmp + " for writing.");
+            out.write(static_cast<const char*>(data), static_cast<std::streamsize>(bytes));
+            out.flush();
+            if (!out) throw std::runtime_error("Could not write " + tmp + ".");
+        }
+        std::remove(path.c_str());
+        if (std::rename(tmp.c_str(), path.c_str()) != 0) throw std::runtime_error("Could not rename " + tmp + ".");
+    };
+
+    std::string backing(header()->backing_path, strnlen(header()->backing_path, SEGMENT_PATH_BYTES));
+    if (backing == dataPath) {
+        // the page is mapped from this very file, it only has to be written back
+        mem->sync();
+    } else {
+        write_file(dataPath, mem->data(), header()->data_bytes);
+    }
+    write_file(metaPath, meta->data(), header()->meta_bytes);
+}
+
+void SharedData::restore(const std::string& shared_mem_name, const std::string& shared_meta_name,
+                         const std::string& metaPath, const std::string& dataPath) {
+    try {
+        long minor0, major0;
+        sample_faults(minor0, major0);
+        Clock::time_point start = Clock::now();
+
+        // the metadata is small, it is copied into a fresh metadata page
+        std::ifstream in(metaPath, std::ios::binary | std::ios::ate);
+        if (!in) throw std::runtime_error("Could not open " + metaPath);
+        std::vector<char> snapshot(static_cast<size_t>(in.tellg()));
+        in.seekg(0);
+        in.read(snapshot.data(), static_cast<std::streamsize>(snapshot.size()));
+        const SegmentHeader* old = static_cast<const SegmentHeader*>(static_cast<const void*>(snapshot.data()));
+        if (!in || snapshot.size() < SEGMENT_HEADER_BYTES + sizeof(metadata) || old->magic != SEGMENT_MAGIC ||
+            old->version != SEGMENT_VERSION || old->meta_bytes != snapshot.size()) {
+            throw std::runtime_error(metaPath + " is not a snapshot of this version of memshare.");
+        }
+        size_t dataBytes = old->data_bytes;
+        if (dataPath.size() >= SEGMENT_PATH_BYTES) throw std::runtime_error("The path " + dataPath + " is too long.");
+
+        split_page_name(shared_mem_name, shared_meta_name, name_space, varname);
+        meta = std::make_unique<MemoryPage>();
+        meta->alloc(shared_meta_name, snapshot.size());
+        std::memcpy(metaPtr(), snapshot.data() + SEGMENT_HEADER_BYTES, snapshot.size() - SEGMENT_HEADER_BYTES);
+
+        // the data is mapped from the snapshot itself, i.e. it is paged in on demand instead of being read and copied
+        mem = std::make_unique<MemoryPage>();
+        mem->map_file(dataPath, dataBytes, true);
+        stats.mmap_secs = seconds_since(start);
+
+        SegmentHeader* h = new (meta->data()) SegmentHeader();
+        h->version = SEGMENT_VERSION;
+        h->meta_bytes = snapshot.size();
+        h->data_bytes = dataBytes;
+        h->created = segment_now();
+        h->alloc_secs = stats.mmap_secs;
+        h->last_access.store(h->created);
+        h->owner_pid = current_pid();
+        h->owner_start = process_start_time(h->owner_pid);
+        if (shared_mem_name.size() < SEGMENT_NAME_BYTES) {
+            std::memcpy(h->data_name, shared_mem_name.c_str(), shared_mem_name.size());
+        }
+        std::memcpy(h->backing_path, dataPath.c_str(), dataPath.size());
+        h->complete.store(1);
+        h->magic = SEGMENT_MAGIC;
+        fault_delta(minor0, major0, stats);
+    } catch (std::exception &e) {
+        throw std::runtime_error("Restore error: " + std::string(e.what()));
+    }
+}
+
 double* SharedData::memPtr() {
     return mem->data();
 }
 
 metadata* SharedData::metaPtr() {
-    return static_cast<metadata*>(static_cast<void*>(meta->data()));
+    return static_cast<metadata*>(static_cast<void*>(static_cast<char*>(static_cast<void*>(meta->data())) + SEGMENT_HEADER_BYTES));
+}
+
+SegmentHeader* SharedData::header() {
+    return static_cast<SegmentHeader*>(static_cast<void*>(meta->data()));
+}
+
+const PageStats& SharedData::localStats() const {
+    return stats;
+}
+
+size_t SharedData::windowCols() const {
+    return window_cols;
+}
+
+bool SharedData::copyOnWrite() const {
+    return copy_on_write;
+}
+
+PageSource SharedData::dataSource() {
+    PageSource source;
+    source.path = std::string(header()->backing_path, strnlen(header()->backing_path, SEGMENT_PATH_BYTES));
+    if (source.path.empty()) source.name = mem->get_name();
+    if (window_cols > 0) source.offset = window_first * metaPtr()->matrix_data.nrow * sizeof(double);
+    return source;
+}
+
+const ColumnStats* SharedData::columnStats() {
+    SegmentHeader* h = header();
+    if (h->stats_columns == 0 || !h->stats_valid.load()) return nullptr;
+    const ColumnStats* stats = static_cast<const ColumnStats*>(static_cast<const void*>(reinterpret_cast<const char*>(h) + h->stats_offset));
+    return stats + window_first;
+}
+
+const std::string& SharedData::nameSpace() const {
+    return name_space;
+}
+
+const std::string& SharedData::varName() const {
+    return varname;
 }
 
 void SharedData::dispose() {
+    // a view detaches from the counters before unmapping
+    if (is_view && meta) header()->active_views.fetch_sub(1);
+    // the owner marks the variable released first; unless a view still maps the data page it goes back to the pool
+    if (!is_view && meta && mem && header()->magic == SEGMENT_MAGIC) {
+        header()->complete.store(0);
+        if (header()->active_views.load() == 0) pool_give(mem);
+    }
+    is_view = false;
     mem.reset();
     meta.reset();
 }
 
 
-std::shared_ptr<SharedData> viewPage(std::string name, std::string metaname) {
-    auto it = views.find(name);
-    if (it != views.end()) {
-        return it->second;
+std::shared_ptr<SharedData> viewPage(std::string name, std::string metaname, size_t firstCol, size_t numCols, bool copyOnWrite) {
+    // a cached view of a variable that is not published; published ones are cached per generation
+    auto cached = views.find(window_key(name, firstCol, numCols, copyOnWrite));
+    if (cached != views.end()) {
+        cached->second->header()->last_access.store(segment_now());
+        return cached->second;
+    }
+
+    for (int attempt = 0; ; attempt++) {
+        // a published variable is viewed in its current generation. Its control page is only looked up if it is known
+        // to be published in this process or if there is no page under its own name (publishPage never creates one).
+        VersionControl* c = controls.find(name) != controls.end() ? version_control(name, metaname, false) : nullptr;
+        std::uint64_t generation = c != nullptr ? c->generation.load() : 0;
+        if (generation == 0) {
+            auto ptr = std::make_shared<SharedData>();
+            try {
+                ptr->view(name, metaname, firstCol, numCols, copyOnWrite);
+                if (!ptr->nameSpace().empty()) catalog_attach(ptr->nameSpace(), ptr->varName(), 1);
+                views.insert({window_key(name, firstCol, numCols, copyOnWrite), ptr});
+                return ptr;
+            } catch (std::exception&) {
+                if (c == nullptr) c = version_control(name, metaname, false);
+                generation = c != nullptr ? c->generation.load() : 0;
+                if (generation == 0) throw;
+            }
+        }
+        std::string pageName = generation_name(name, generation);
+        std::string pageMetaname = generation_name(metaname, generation);
+
+        std::string key = window_key(pageName, firstCol, numCols, copyOnWrite);
+        auto it = views.find(key);
+        if (it != views.end()) {
+            it->second->header()->last_access.store(segment_now());
+            return it->second;
+        }
+        auto ptr = std::make_shared<SharedData>();
+        try {
+            ptr->view(pageName, pageMetaname, firstCol, numCols, copyOnWrite);
+        } catch (std::exception&) {
+            // the generation was superseded and removed in between, look up the current one again
+            if (attempt < 100 && c->generation.load() != generation) continue;
+            throw;
+        }
+        if (!ptr->nameSpace().empty()) catalog_attach(ptr->nameSpace(), ptr->varName(), 1);
+        views.insert({key, ptr});
+        return ptr;
+    }
+}
+
+bool hasView(const std::string& name) {
+    return !view_keys(name).empty();
+}
+
+void check_variable_name(const std::string& varname) {
+    if (varname.find('@') != std::string::npos) {
+        stop("Variable name " + varname + " must not contain '@', which marks the generations of published variables!");
+    }
+}
+
+// the variable of a page name to be registered has to pass check_variable_name
+static void check_page_name(const std::string& name, const std::string& metaname) {
+    std::string name_space, varname;
+    split_page_name(name, metaname, name_space, varname);
+    if (!name_space.empty()) check_variable_name(name.substr(name_space.size() + 1));
+}
+
+// add a freshly allocated page to the catalog of its namespace; the page is removed again if this fails
+static void catalogPage(SharedData* ptr) {
+    if (ptr->nameSpace().empty()) return;
+    catalog_register(ptr->nameSpace(), ptr->varName(), ptr->header()->data_bytes + ptr->header()->meta_bytes);
+}
+
+void registerPage(std::string name, std::string metaname, SEXP obj, int threads, numa_placement placement, bool stats) {
+    check_page_name(name, metaname);
+    // a published variable has no segment of this name that would collide
+    if (pages.find(name) != pages.end()) stop("Variable " + name + " is already registered!");
+    auto ptr = std::make_unique<SharedData>();
+    ptr->alloc(name, metaname, obj, threads, placement, stats);
+    catalogPage(ptr.get());
+    pages.insert({name, std::move(ptr)});
+}
+
+std::uint64_t publishPage(std::string name, std::string metaname, SEXP obj, int threads) {
+    check_page_name(name, metaname);
+    auto it = pages.find(name);
+    bool first = it == pages.end();
+    if (!first && controls.find(name) == controls.end()) {
+        stop("Variable " + name + " was registered by registerVariables, release it before publishing it!");
+    }
+    VersionControl* c = version_control(name, metaname, true);
+    if (c == nullptr) stop("Variable " + name + " is being published by another process!");
+    if (first && c->owner_pid != current_pid()) {
+        if (process_alive(c->owner_pid, c->owner_start)) {
+            controls.erase(name);
+            stop("Variable " + name + " is published by another process!");
+        }
+        // its owner died; continue its generations so that their names are not reused
+        c->owner_pid = current_pid();
+        c->owner_start = process_start_time(c->owner_pid);
+    }
+
+    std::uint64_t generation = c->generation.load() + 1;
+    auto ptr = std::make_unique<SharedData>();
+    try {
+        ptr->alloc(generation_name(name, generation), generation_name(metaname, generation), obj, threads);
+        if (first) catalogPage(ptr.get());
+        else catalog_resize(ptr->nameSpace(), ptr->varName(), ptr->header()->data_bytes + ptr->header()->meta_bytes);
+    } catch (...) {
+        if (first) retire_control(name);
+        throw;
+    }
+
+    // the flip: viewers pick up the new generation with their next retrieval. Replacing the page unlinks the previous
+    // generation; viewers still holding it keep their mapping until they release it.
+    c->generation.store(generation);
+    if (first) pages.insert({name, std::move(ptr)});
+    else it->second = std::move(ptr);
+    return generation;
+}
+
+double* allocMatrixPage(std::string name, std::string metaname, size_t nrow, size_t ncol, metadata::type type) {
+    check_page_name(name, metaname);
+    auto ptr = std::make_unique<SharedData>();
+    double* data = ptr->alloc_matrix(name, metaname, nrow, ncol, type);
+    pages.insert({name, std::move(ptr)});
+    return data;
+}
+
+void completeMatrixPage(const std::string& name) {
+    SharedData* ptr = pages.at(name).get();
+    // viewers attach only to complete pages
+    ptr->header()->complete.store(1);
+    catalogPage(ptr);
+}
+
+int registerPagesAsync(const std::vector<std::string>& names, const std::vector<std::string>& metanames, List objs, int threads) {
+    auto job = std::make_unique<AsyncJob>();
+    job->names = names;
+    job->metanames = metanames;
+
+    // everything that needs R happens here: the layout of the objects and the quotas
+    std::map<std::string, std::uint64_t> bytes;
+    for (R_xlen_t i = 0; i < objs.size(); i++) {
+        job->plans.push_back(plan_copy(objs[i]));
+        if (pages.find(names[i]) != pages.end()) stop("Variable " + names[i] + " is already registered!");
+        check_page_name(names[i], metanames[i]);
+        std::string name_space, varname;
+        split_page_name(names[i], metanames[i], name_space, varname);
+        bytes[name_space] += job->plans.back().dataBytes + SEGMENT_HEADER_BYTES + job->plans.back().meta.size() * sizeof(metadata);
+    }
+    for (auto const& b : bytes) checkPageQuota(b.first, b.second);
+
+    job->objs = objs;
+    R_PreserveObject(job->objs);
+    AsyncJob* j = job.get();
+    try {
+        j->worker = std::thread([j, threads]() {
+            for (size_t i = 0; i < j->plans.size(); i++) {
+                try {
+                    auto ptr = std::make_unique<SharedData>();
+                    ptr->fill(j->names[i], j->metanames[i], j->plans[i], threads, false);
+                    catalogPage(ptr.get());
+                    j->results.push_back(std::move(ptr));
+                } catch (std::exception& e) {
+                    j->error = "Allocation error of " + j->names[i] + ": " + e.what();
+                    break;
+                }
+            }
+            j->done.store(true);
+        });
+    } catch (...) {
+        // the thread could not be started
+        R_ReleaseObject(job->objs);
+        throw;
+    }
+    int id = nextAsyncJob++;
+    asyncJobs[id] = std::move(job);
+    return id;
+}
+
+bool readyPagesAsync(int id) {
+    auto it = asyncJobs.find(id);
+    if (it == asyncJobs.end()) stop("Unknown or already completed asynchronous registration!");
+    return it->second->done.load();
+}
+
+std::vector<std::string> waitPagesAsync(int id) {
+    auto it = asyncJobs.find(id);
+    if (it == asyncJobs.end()) stop("Unknown or already completed asynchronous registration!");
+    std::unique_ptr<AsyncJob> job = std::move(it->second);
+    asyncJobs.erase(it);
+    job->worker.join();
+    R_ReleaseObject(job->objs);
+
+    std::vector<std::string> registered;
+    for (auto& ptr : job->results) {
+        registered.push_back(job->names[registered.size()]);
+        pages.insert({registered.back(), std::move(ptr)});
     }
-    auto ptr = std::make_shared<SharedData>();
-    ptr->view(name, metaname);
-    views.insert({name, ptr});
-    return ptr;
+    if (!job->error.empty()) stop(job->error);
+    return registered;
 }
 
-void registerPage(std::string name, std::string metaname, SEXP obj) {
+void setPageQuota(const std::string& name_space, std::uint64_t bytes) {
+    std::lock_guard<std::mutex> lock(quotaMutex);
+    if (bytes == 0) {
+        quotas.erase(name_space);
+    } else {
+        quotas[name_space] = bytes;
+    }
+}
+
+std::uint64_t getPageQuota(const std::string& name_space, std::uint64_t& used) {
+    // an arena counts with its whole section from its creation on, its variables only as part of it
+    std::uint64_t blocks;
+    std::uint64_t arena = arena_charge(name_space, blocks);
+    if (name_space.empty()) {
+        used = owned_bytes() + arena;
+    } else {
+        used = catalog_usage(name_space);
+        used = used - std::min(used, blocks) + arena;
+    }
+    std::lock_guard<std::mutex> lock(quotaMutex);
+    auto it = quotas.find(name_space);
+    return it == quotas.end() ? 0 : it->second;
+}
+
+void checkPageQuota(const std::string& name_space, std::uint64_t bytes) {
+    std::uint64_t used;
+    std::uint64_t quota = getPageQuota("", used);
+    if (quota > 0 && used + bytes > quota) {
+        throw std::runtime_error("Registering " + std::to_string(bytes) + " bytes exceeds the global quota of " +
+                                 std::to_string(quota) + " bytes (" + std::to_string(used) + " bytes in use)!");
+    }
+    if (name_space.empty()) return;
+    quota = getPageQuota(name_space, used);
+    if (quota > 0 && used + bytes > quota) {
+        throw std::runtime_error("Registering " + std::to_string(bytes) + " bytes exceeds the quota of namespace " + name_space +
+                                 " of " + std::to_string(quota) + " bytes (" + std::to_string(used) + " bytes in use)!");
+    }
+}
+
+void snapshotPage(std::string name, std::string metaname, std::string metaPath, std::string dataPath) {
+    auto it = pages.find(name);
+    if (it != pages.end()) {
+        it->second->snapshot(metaPath, dataPath);
+        return;
+    }
+    bool hadView = hasView(name);
+    auto view = viewPage(name, metaname);
+    try {
+        view->snapshot(metaPath, dataPath);
+    } catch (...) {
+        if (!hadView) releaseView(name);
+        throw;
+    }
+    if (!hadView) releaseView(name);
+}
+
+void restorePage(std::string name, std::string metaname, std::string metaPath, std::string dataPath) {
+    check_page_name(name, metaname);
     auto ptr = std::make_unique<SharedData>();
-    ptr->alloc(name, metaname, obj);
+    ptr->restore(name, metaname, metaPath, dataPath);
+    catalogPage(ptr.get());
     pages.insert({name, std::move(ptr)});
 }
 
@@ -157,17 +837,28 @@ void releasePage(std::string name) {
     if (it == pages.end()) {
       stop("Tried to release variable " + name + " which was not previously allocated in this compilation unit!");
     }
-    if (it->second) it->second->dispose();
+    retire_control(name);
+    if (it->second) {
+        if (!it->second->nameSpace().empty()) catalog_unregister(it->second->nameSpace(), it->second->varName());
+        it->second->dispose();
+    }
     pages.erase(it);
 }
 
 void releaseView(std::string name) {
-    auto it = views.find(name);
-    if (it == views.end()) {
+    // every generation of a published variable this process still holds
+    std::vector<std::string> keys = view_keys(name);
+    if (keys.empty()) {
       stop("Tried to release variable " + name + " which was not previously allocated in this compilation unit!");
     }
-    if (it->second) it->second->dispose();
-    views.erase(it);
+    for (const std::string& key : keys) {
+        auto it = views.find(key);
+        if (it->second && !it->second->nameSpace().empty()) {
+            catalog_attach(it->second->nameSpace(), it->second->varName(), -1);
+        }
+        // tiles may still hold the view (see retrieveTile); it is unmapped with its last holder (see ~SharedData)
+        views.erase(it);
+    }
 }
 std::vector<std::string> getSharedViews() {
     std::vector<std::string> viewNames;
@@ -181,3 +872,52 @@ std::vector<std::string> getSharedPages() {
         pageNames.push_back(key.first);
     return pageNames;
 }
+
+DataFrame getSharedStats(bool owned) {
+    std::vector<std::pair<std::string, SharedData*>> entries;
+    if (owned) {
+        for (auto const& p : pages) entries.push_back({p.first, p.second.get()});
+    } else {
+        for (auto const& v : views) entries.push_back({v.first, v.second.get()});
+    }
+
+    R_xlen_t n = entries.size();
+    CharacterVector name(n);
+    NumericVector bytes(n), metaBytes(n), allocSecs(n), memcpySecs(n), memcpyGbps(n), mmapSecs(n), attachCount(n), activeViews(n),
+        created(n), lastAccess(n), minorFaults(n), majorFaults(n);
+    for (R_xlen_t i = 0; i < n; i++) {
+        SharedData* data = entries[i].second;
+        SegmentHeader* h = data->header();
+        const PageStats& s = data->localStats();
+        name[i] = entries[i].first;
+        bytes[i] = static_cast<double>(h->data_bytes);
+        metaBytes[i] = static_cast<double>(h->meta_bytes);
+        allocSecs[i] = h->alloc_secs;
+        memcpySecs[i] = h->memcpy_secs;
+        memcpyGbps[i] = h->memcpy_secs > 0 ? h->data_bytes / h->memcpy_secs / 1e9 : NA_REAL;
+        mmapSecs[i] = s.mmap_secs;
+        attachCount[i] = static_cast<double>(h->attach_count.load());
+        activeViews[i] = static_cast<double>(h->active_views.load());
+        // times are handed to R in seconds since the epoch
+        created[i] = h->created / 1e6;
+        lastAccess[i] = h->last_access.load() / 1e6;
+        minorFaults[i] = s.minor_faults < 0 ? NA_REAL : static_cast<double>(s.minor_faults);
+        majorFaults[i] = s.major_faults < 0 ? NA_REAL : static_cast<double>(s.major_faults);
+    }
+    return DataFrame::create(
+        Named("name") = name,
+        Named("bytes") = bytes,
+        Named("meta_bytes") = metaBytes,
+        Named("alloc_secs") = allocSecs,
+        Named("memcpy_secs") = memcpySecs,
+        Named("memcpy_gbps") = memcpyGbps,
+        Named("mmap_secs") = mmapSecs,
+        Named("attach_count") = attachCount,
+        Named("active_views") = activeViews,
+        Named("created") = created,
+        Named("last_access") = lastAccess,
+        Named("minor_faults") = minorFaults,
+        Named("major_faults") = majorFaults,
+        Named("stringsAsFactors") = false
+    );
+}
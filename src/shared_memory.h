@@ -6,8 +6,13 @@
 #include <memory>
 #include <cstring>
 #include <string>
+#include <utility>
+#include <vector>
 
+#include "column_stats.h"
 #include "metadata.h"
+#include "numa.h"
+#include "segment_header.h"
 
 
 #ifdef _WIN32
@@ -23,6 +28,34 @@
 using namespace Rcpp;
 using namespace std;
 
+/**
+ * Counters of a SharedData instance that are local to the process holding it.
+ */
+struct PageStats {
+    double mmap_secs = 0;       // time this process spent in creating (owner) or attaching (viewer) the pages
+    long minor_faults = -1;     // page faults of this process during registration or attach; -1 if not available
+    long major_faults = -1;
+};
+
+/**
+ * The layout of an object to register and the location of its doubles. It is taken from the R object on the main
+ * thread so that the copy itself can run on any thread (see SharedData::fill); the object has to stay protected
+ * until then.
+ */
+struct CopyPlan {
+    std::vector<metadata> meta;                                 // one element, or n + 1 for lists
+    std::vector<std::pair<const double*, size_t>> sources;      // the doubles of the object (of every list element)
+    size_t dataBytes = 0;                                       // size of the data page
+    size_t largestBytes = 0;                                    // size of the largest source
+    numa_placement placement = NUMA_DEFAULT;                    // placement of the data page (see numa.h)
+    bool stats = false;                                         // whether to compute column statistics (matrices and vectors)
+};
+
+/**
+ * Makes the plan for copying an object (double matrix, double vector or a list of these) into shared memory.
+ */
+CopyPlan plan_copy(SEXP obj);
+
 /**
  * A class encapsulating a memory page with its metadata.
  */
@@ -31,6 +64,26 @@ class SharedData {
 protected:
     std::unique_ptr<MemoryPage> mem, meta;
     std::string metaname;
+    std::string name_space, varname;
+    bool is_view = false;
+    size_t window_cols = 0;     // number of columns mapped by a window view (see view), 0 for the whole page
+    size_t window_first = 0;    // first column of a window view
+    bool copy_on_write = false; // whether the data page of a view is mapped privately (see view)
+    bool recycled = false;      // whether the data page was taken from the pool (see pool.h), i.e. is not zero-filled
+    PageStats stats;
+
+    /**
+     * Creates the metadata page (header followed by the given metadata) and the data page of dataBytes bytes.
+     * 
+     * @param m           Array of the metadata of the object (one element, or n + 1 for lists).
+     * @param nmeta       Length of m.
+     * @param dataBytes   Size of the data page.
+     * @param populate    Whether to map the data page up front (see MemoryPage::alloc).
+     * @param checkQuota  Whether to check the quotas (see setPageQuota); this reads pages, i.e. only the main thread may.
+     * @param statsColumns  Number of column statistics (see column_stats.h) to reserve behind the metadata.
+     */
+    void alloc_pages(const std::string& shared_mem_name, const std::string& shared_meta_name, const metadata* m,
+                     size_t nmeta, size_t dataBytes, bool populate = false, bool checkQuota = true, size_t statsColumns = 0);
 
 public:
     /**
@@ -39,16 +92,70 @@ public:
      * @param shared_mem_name     Unique identifier for the memory page holding the actual data
      * @param shared_meta_name    Unique identifier for the memory page holding the metadata information
      * @param obj                 The object that gets copied into the memory page.
+     * @param threads             Number of threads copying large objects (0 = all available), see parallel_copy.
+     * @param placement           NUMA placement of the data page, see numa.h.
+     * @param stats               Whether to compute the column statistics of a matrix or vector while copying it.
+     */
+    void alloc(const std::string& shared_mem_name, const std::string& shared_meta_name, SEXP obj, int threads = 0,
+               numa_placement placement = NUMA_DEFAULT, bool stats = false);
+
+    /**
+     * Allocates a new memory page and copies the object described by plan into it. Does not call into R, hence it
+     * may run on a background thread. The page becomes visible to viewers when the copy is complete.
+     * 
+     * @param shared_mem_name     Unique identifier for the memory page holding the actual data
+     * @param shared_meta_name    Unique identifier for the memory page holding the metadata information
+     * @param plan                See plan_copy.
+     * @param threads             Number of threads copying large objects (0 = all available), see parallel_copy.
+     * @param checkQuota          See alloc_pages.
+     */
+    void fill(const std::string& shared_mem_name, const std::string& shared_meta_name, const CopyPlan& plan,
+              int threads, bool checkQuota);
+
+    /**
+     * Allocates a new, zero-initialized matrix memory page that is filled from C++ instead of being copied from an R object.
+     * 
+     * @param shared_mem_name     Unique identifier for the memory page holding the actual data
+     * @param shared_meta_name    Unique identifier for the memory page holding the metadata information
+     * @param nrow, ncol          Dimensions of the matrix.
+     * @param type                MATRIX, or CODES for a page of other data packed into nrow * ncol doubles.
+     * 
+     * @result  Writable pointer to the nrow * ncol doubles (column-major) of the page. The page stays incomplete, i.e.
+     *          invisible to viewers, until the caller has filled it and sets header()->complete.
      */
-    void alloc(const std::string& shared_mem_name, const std::string& shared_meta_name, SEXP obj);
+    double* alloc_matrix(const std::string& shared_mem_name, const std::string& shared_meta_name, size_t nrow, size_t ncol,
+                         metadata::type type = metadata::MATRIX);
 
     /**
      * Retrieves an already existing memory page for a given identifier set.
      * 
      * @param shared_mem_name     Unique identifier for the memory page holding the actual data
      * @param shared_meta_name    Unique identifier for the memory page holding the metadata information
+     * @param firstCol, numCols   Matrices only: map just the columns firstCol, ..., firstCol + numCols - 1 (0-based),
+     *                            memPtr then points to the first of them; numCols = 0 maps the whole page.
+     * @param copyOnWrite         Map the data page privately and writable: written memory pages are copied for this
+     *                            process and stay invisible to all others (see MemoryPage::view).
+     */
+    void view(const std::string& shared_mem_name, const std::string& shared_meta_name, size_t firstCol = 0, size_t numCols = 0,
+              bool copyOnWrite = false);
+
+    /**
+     * Writes the metadata page and the data page in their native layout to two files.
+     * 
+     * @param metaPath, dataPath    Paths of the files.
      */
-    void view(const std::string& shared_mem_name, const std::string& shared_meta_name);
+    void snapshot(const std::string& metaPath, const std::string& dataPath);
+
+    /**
+     * Takes ownership of a snapshot (see snapshot): the metadata is copied into a new metadata page and the data page
+     * is mapped from the data file, so that its content is paged in on demand. Viewers map the file as well.
+     * 
+     * @param shared_mem_name     Unique identifier for the memory page holding the actual data
+     * @param shared_meta_name    Unique identifier for the memory page holding the metadata information
+     * @param metaPath, dataPath  Paths of the snapshot files; dataPath has to be absolute.
+     */
+    void restore(const std::string& shared_mem_name, const std::string& shared_meta_name,
+                 const std::string& metaPath, const std::string& dataPath);
 
     /**
      * Disposes of this particular instance. In effect this simply deletes mem and meta; see their destructors
@@ -69,14 +176,52 @@ public:
     metadata* metaPtr();
 
     /**
-     * Empty destructor.
+     * Accessor for the header of the metadata page which holds the counters shared by all processes.
+     */
+    SegmentHeader* header();
+
+    /**
+     * The number of columns mapped by a window view; 0 if the whole page is mapped.
+     */
+    size_t windowCols() const;
+
+    /**
+     * Whether the data page of this view may be written (privately, see view).
      */
-    ~SharedData() {}
+    bool copyOnWrite() const;
+
+    /**
+     * Where the data of this view (of its window) lies, for mapping it privately once more (see make_altrep_matrix).
+     */
+    PageSource dataSource();
+
+    /**
+     * The statistics of the columns of the page (of the first column of a window view); nullptr if none were computed
+     * or an in-place update made them stale.
+     */
+    const ColumnStats* columnStats();
+
+    /**
+     * Accessor for the counters local to this process.
+     */
+    const PageStats& localStats() const;
+
+    /**
+     * The namespace and the variable name of the page (derived from the page names); empty if they cannot be told apart.
+     */
+    const std::string& nameSpace() const;
+    const std::string& varName() const;
+
+    /**
+     * The destructor detaches a view from the counters of the header; see dispose.
+     */
+    ~SharedData() { dispose(); }
 };
 
 
 /**
  * Data structures for holding the currently open pages and views for this instance of the memshare dll/so.
+ * Registrations, views and releases are mirrored into the catalog of the namespace (see catalog.h).
  */
 extern std::map<std::string, std::unique_ptr<SharedData>> pages;
 extern std::map<std::string, std::shared_ptr<SharedData>> views;
@@ -87,10 +232,30 @@ extern std::map<std::string, std::shared_ptr<SharedData>> views;
  * @param shm_mem_name      The unique identifier of the actual data page.
  * @param shm_meta_name     The unique identifier of its metadata page.
  * 
+ * @param firstCol, numCols   Matrices only: view just these columns (see SharedData::view); 0 columns view all.
+ *                          Every window is a view of its own, releaseView releases all of them.
+ * @param copyOnWrite       View the page privately (see SharedData::view). Such a view is separate from the shared
+ *                          one of the same page; its private changes are seen by all its ALTREPs in this process.
+ * 
  * @result  A shared_ptr pointing to a new instance of SharedData which manages the memory state internally.
  *          This can be used to construct an ALTREP pointer to the data retrieved.
  */
-std::shared_ptr<SharedData> viewPage(std::string shm_mem_name, std::string shm_meta_name);
+std::shared_ptr<SharedData> viewPage(std::string shm_mem_name, std::string shm_meta_name, size_t firstCol = 0, size_t numCols = 0,
+                                     bool copyOnWrite = false);
+
+/**
+ * Whether this process holds a view of a page (of any generation of a published variable, see publishPage, or any
+ * window of it).
+ * 
+ * @param name          The unique identifier of the data page.
+ */
+bool hasView(const std::string& name);
+
+/**
+ * Throws if a variable name of the user contains '@', which separates the generation of a published variable from its
+ * name (see publishPage). All functions registering pages check their names.
+ */
+void check_variable_name(const std::string& varname);
 
 /**
  * Register a new memory page for a given object. The page is added to pages.
@@ -98,8 +263,119 @@ std::shared_ptr<SharedData> viewPage(std::string shm_mem_name, std::string shm_m
  * @param name          The unique identifier of the actual data page.
  * @param metaname      The unique identifier of its metadata page.
  * @param obj           The object to register (double matrix, double vector or a list of these).
+ * @param threads       Number of threads copying large objects (0 = all available).
+ * @param placement     NUMA placement of the data page, see numa.h.
+ * @param stats         Whether to compute the column statistics of a matrix or vector (see column_stats.h).
+ */
+void registerPage(std::string name, std::string metaname, SEXP obj, int threads = 0, numa_placement placement = NUMA_DEFAULT,
+                  bool stats = false);
+
+/**
+ * Publish a new generation of a versioned variable. The generation is registered as a pair of pages whose names carry
+ * the suffix "@<generation>"; once it is filled, the control page of the variable (see VersionControl) is flipped to it
+ * and viewPage resolves the variable to it from then on. The previous generation is unlinked right away, viewers
+ * holding it keep their mapping until they release it (on Windows the section lives until its last handle is closed).
+ * The page is kept in pages under name, i.e. releasePage removes the variable with its control page.
+ * 
+ * @param name          The unique identifier of the actual data page.
+ * @param metaname      The unique identifier of its metadata page.
+ * @param obj           The object to publish (double matrix, double vector or a list of these).
+ * @param threads       Number of threads copying large objects (0 = all available).
+ * 
+ * @result  The generation published, starting at 1.
+ */
+std::uint64_t publishPage(std::string name, std::string metaname, SEXP obj, int threads = 0);
+
+/**
+ * Register new memory pages for a list of objects on a background thread. The objects are protected until the
+ * registration is reaped by waitPagesAsync; they must not be modified in place until then. Every page becomes visible
+ * to viewers (and in the catalog) only once it is completely filled; it is added to pages by waitPagesAsync.
+ * 
+ * @param names         The unique identifiers of the data pages.
+ * @param metanames     The unique identifiers of their metadata pages.
+ * @param objs          The objects to register (double matrices, double vectors or lists of these).
+ * @param threads       Number of threads copying large objects (0 = all available).
+ * 
+ * @result  The id of the registration.
+ */
+int registerPagesAsync(const std::vector<std::string>& names, const std::vector<std::string>& metanames, List objs, int threads);
+
+/**
+ * Whether the asynchronous registration id has finished (successfully or not).
+ */
+bool readyPagesAsync(int id);
+
+/**
+ * Waits for the asynchronous registration id to finish and adds its pages to pages. The first error of the
+ * registration is rethrown; the pages registered before it stay registered.
+ * 
+ * @result  The names of the registered data pages.
  */
-void registerPage(std::string name, std::string metaname, SEXP obj);
+std::vector<std::string> waitPagesAsync(int id);
+
+/**
+ * Allocate a new, zero-initialized matrix page that gets filled from C++. The page is added to pages, so that
+ * releasePage discards it if the fill fails, but it is neither visible to viewers nor listed in the catalog of its
+ * namespace before completeMatrixPage.
+ * 
+ * @param name          The unique identifier of the actual data page.
+ * @param metaname      The unique identifier of its metadata page.
+ * @param nrow, ncol    Dimensions of the matrix.
+ * @param type          See SharedData::alloc_matrix.
+ * 
+ * @result  Writable pointer to the data of the page; it stays valid until the page is released.
+ */
+double* allocMatrixPage(std::string name, std::string metaname, size_t nrow, size_t ncol,
+                        metadata::type type = metadata::MATRIX);
+
+/**
+ * Publish a page of allocMatrixPage after its fill: viewers may attach to it and it is added to the catalog.
+ * 
+ * @param name          The unique identifier of the actual data page.
+ */
+void completeMatrixPage(const std::string& name);
+
+/**
+ * Write a snapshot of a page (owned or viewed) to files; see SharedData::snapshot.
+ * 
+ * @param name          The unique identifier of the actual data page.
+ * @param metaname      The unique identifier of its metadata page.
+ * @param metaPath, dataPath    Paths of the snapshot files.
+ */
+void snapshotPage(std::string name, std::string metaname, std::string metaPath, std::string dataPath);
+
+/**
+ * Register a page from a snapshot; see SharedData::restore. The page is added to pages.
+ * 
+ * @param name          The unique identifier of the actual data page.
+ * @param metaname      The unique identifier of its metadata page.
+ * @param metaPath, dataPath    Paths of the snapshot files.
+ */
+void restorePage(std::string name, std::string metaname, std::string metaPath, std::string dataPath);
+
+/**
+ * Byte quotas that are checked before a page is created; a registration exceeding one fails with an error.
+ * The quota of a namespace limits the size of all its variables registered by any process (as counted by its catalog),
+ * the global quota (empty name_space) limits the size of all pages owned by this process. An arena (see arena.h) counts
+ * with the size of its section instead of its variables. A quota of 0 means no limit.
+ * Concurrent registrations in different processes are checked independently, hence the quotas are soft.
+ * 
+ * @param name_space    The namespace or "" for the global quota.
+ * @param bytes         The quota in bytes.
+ */
+void setPageQuota(const std::string& name_space, std::uint64_t bytes);
+
+/**
+ * Get the quota of a namespace (or the global quota for "") and its current usage in bytes.
+ * 
+ * @result  The quota (0 if there is none).
+ */
+std::uint64_t getPageQuota(const std::string& name_space, std::uint64_t& used);
+
+/**
+ * Check the quotas before registering bytes in a namespace; throws if one of them would be exceeded.
+ */
+void checkPageQuota(const std::string& name_space, std::uint64_t bytes);
 
 /**
  * Release a memory page from ownership of this component.
@@ -115,6 +391,7 @@ void releasePage(std::string name);
 /**
  * Release a memory page from viewership of this component.
  * This should always happen *before* the memory is released from ownership of its owner process.
+ * All windows of the page and, for a published variable, all generations held by this process are released.
  * 
  * @param name          The unique identifier of the data page.
  */
@@ -133,3 +410,10 @@ std::vector<std::string> getSharedViews();
  * @result  A vector containing the memory page names
  */
 std::vector<std::string> getSharedPages();
+
+/**
+ * Get the statistics of the pages in ownership (owned = true) or viewership (owned = false) of the current process.
+ * 
+ * @result  A data.frame with one row per page, see pageStats() in R for the columns.
+ */
+DataFrame getSharedStats(bool owned);
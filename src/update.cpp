@@ -0,0 +1,194 @@
+#include "update.h"
+
+#include <cstring>
+#include <vector>
+
+#include "metadata.h"
+#include "shared_memory.h"
+
+namespace {
+
+// 0-based indices from 1-based R indices; all of [0, n) for NULL
+std::vector<size_t> index_of(SEXP idx, size_t n, const char* what) {
+    std::vector<size_t> result;
+    if (Rf_isNull(idx)) {
+        result.resize(n);
+        for (size_t i = 0; i < n; i++) result[i] = i;
+        return result;
+    }
+    IntegerVector v = as<IntegerVector>(idx);
+    result.reserve(v.size());
+    for (R_xlen_t i = 0; i < v.size(); i++) {
+        if (v[i] == NA_INTEGER || v[i] < 1 || static_cast<size_t>(v[i]) > n) {
+            stop("The %s indices have to be between 1 and %d!", what, static_cast<int>(n));
+        }
+        result.push_back(static_cast<size_t>(v[i]) - 1);
+    }
+    return result;
+}
+
+// whether idx is a contiguous run, which is copied as one block
+bool contiguous(const std::vector<size_t>& idx) {
+    for (size_t i = 1; i < idx.size(); i++) {
+        if (idx[i] != idx[i - 1] + 1) return false;
+    }
+    return true;
+}
+
+// the dimensions of a matrix or vector page; vectors are one column
+void dimensions_of(SharedData* page, const std::string& varname, size_t& nrow, size_t& ncol, bool& isMatrix) {
+    metadata* m = page->metaPtr();
+    if (m->data_type == metadata::type::MATRIX) {
+        nrow = m->matrix_data.nrow;
+        ncol = m->matrix_data.ncol;
+        isMatrix = true;
+    } else if (m->data_type == metadata::type::VECTOR) {
+        nrow = m->vector_data.n;
+        ncol = 1;
+        isMatrix = false;
+    } else if (m->data_type == metadata::type::CODES) {
+        stop("Variable " + varname + " holds the grid codes of mutualinfoMatrix; only matrices and vectors can be updated or read partially!");
+    } else {
+        stop("Variable " + varname + " is a list; only matrices and vectors can be updated or read partially!");
+    }
+}
+
+}
+
+void updateVariable(std::string name_space, std::string varname, NumericVector value, SEXP rows, SEXP cols, double offset) {
+#ifdef _WIN32
+    // For windows we prepend the namespace identifier by "Local\\" because otherwise the shared memory is shared system-wide (instead of user-wide) which needs admin privileges
+    name_space = "Local\\" + name_space;
+#endif
+    auto it = pages.find(name_space + "." + varname);
+    if (it == pages.end()) {
+        stop("Variable " + varname + " can only be updated by the process that registered it!");
+    }
+    SharedData* page = it->second.get();
+    size_t nrow, ncol;
+    bool isMatrix;
+    dimensions_of(page, varname, nrow, ncol, isMatrix);
+    if (!isMatrix && !Rf_isNull(cols)) stop("cols can only be given for matrices!");
+
+    std::vector<size_t> r, c = index_of(cols, ncol, "column");
+    if (!ISNAN(offset)) {
+        if (isMatrix || !Rf_isNull(rows)) stop("offset can only be given for vectors and not together with rows!");
+        if (offset < 1 || offset - 1 + value.size() > nrow) stop("The values do not fit into the vector at this offset!");
+        r.resize(value.size());
+        for (size_t i = 0; i < r.size(); i++) r[i] = static_cast<size_t>(offset) - 1 + i;
+    } else {
+        r = index_of(rows, nrow, isMatrix ? "row" : "element");
+    }
+    size_t count = r.size() * c.size();
+    if (static_cast<size_t>(value.size()) != count && value.size() != 1) {
+        stop("value has %d elements instead of %d (or 1)!", static_cast<int>(value.size()), static_cast<int>(count));
+    }
+
+    double* data = page->memPtr();
+    const double* v = value.begin();
+    bool scalar = value.size() == 1 && count != 1;
+    bool block = !scalar && contiguous(r);
+    SegmentHeader* h = page->header();
+    // the column statistics (see column_stats.h) are not maintained by updates
+    h->stats_valid.store(0);
+    segment_write_begin(h);
+    for (size_t j = 0; j < c.size(); j++) {
+        double* column = data + c[j] * nrow;
+        if (block) {
+            if (!r.empty()) std::memcpy(column + r[0], v + j * r.size(), r.size() * sizeof(double));
+        } else {
+            for (size_t i = 0; i < r.size(); i++) column[r[i]] = scalar ? v[0] : v[j * r.size() + i];
+        }
+    }
+    segment_write_end(h);
+    h->last_access.store(segment_now());
+}
+
+SEXP readVariable(std::string name_space, std::string varname, SEXP rows, SEXP cols, double timeout) {
+#ifdef _WIN32
+    // For windows we prepend the namespace identifier by "Local\\" because otherwise the shared memory is shared system-wide (instead of user-wide) which needs admin privileges
+    name_space = "Local\\" + name_space;
+#endif
+    // read from the own page or a view; only drop the view afterwards if this call opened it
+    std::string name = name_space + "." + varname;
+    auto owned = pages.find(name);
+    bool hadView = owned != pages.end() || hasView(name);
+    SharedData* page = owned != pages.end() ? owned->second.get() : viewPage(name, name_space + ".md." + varname).get();
+    try {
+        size_t nrow, ncol;
+        bool isMatrix;
+        dimensions_of(page, varname, nrow, ncol, isMatrix);
+        if (!isMatrix && !Rf_isNull(cols)) stop("cols can only be given for matrices!");
+        std::vector<size_t> r = index_of(rows, nrow, isMatrix ? "row" : "element");
+        std::vector<size_t> c = index_of(cols, ncol, "column");
+
+        RObject result = isMatrix ? static_cast<SEXP>(NumericMatrix(static_cast<int>(r.size()), static_cast<int>(c.size())))
+                                  : static_cast<SEXP>(NumericVector(r.size()));
+        double* out = REAL(result);
+        const double* data = page->memPtr();
+        const SegmentHeader* h = page->header();
+        bool block = contiguous(r);
+        std::uint64_t seq;
+        do {
+            seq = segment_read_begin(h, timeout);
+            for (size_t j = 0; j < c.size(); j++) {
+                const double* column = data + c[j] * nrow;
+                if (block) {
+                    if (!r.empty()) std::memcpy(out + j * r.size(), column + r[0], r.size() * sizeof(double));
+                } else {
+                    for (size_t i = 0; i < r.size(); i++) out[j * r.size() + i] = column[r[i]];
+                }
+            }
+        } while (segment_read_retry(h, seq));
+        if (!hadView) releaseView(name);
+        return result;
+    } catch (...) {
+        if (!hadView) releaseView(name);
+        throw;
+    }
+}
+
+double variableVersion(std::string name_space, std::string varname) {
+#ifdef _WIN32
+    // For windows we prepend the namespace identifier by "Local\\" because otherwise the shared memory is shared system-wide (instead of user-wide) which needs admin privileges
+    name_space = "Local\\" + name_space;
+#endif
+    std::string name = name_space + "." + varname;
+    auto owned = pages.find(name);
+    bool hadView = owned != pages.end() || hasView(name);
+    SharedData* page = owned != pages.end() ? owned->second.get() : viewPage(name, name_space + ".md." + varname).get();
+    std::uint64_t seq = page->header()->sequence.load(std::memory_order_acquire);
+    if (!hadView) releaseView(name);
+    return seq % 2 == 1 ? NA_REAL : static_cast<double>(seq / 2);
+}
+
+extern "C" SEXP C_updateVariable(SEXP name_spaceSEXP, SEXP varnameSEXP, SEXP valueSEXP, SEXP rowsSEXP, SEXP colsSEXP, SEXP offsetSEXP) {
+    try {
+        updateVariable(as<std::string>(name_spaceSEXP), as<std::string>(varnameSEXP), as<NumericVector>(valueSEXP),
+                       rowsSEXP, colsSEXP, as<double>(offsetSEXP));
+        return R_NilValue; // function returns void
+    } catch (std::exception &e) {
+        Rf_error("updateVariable error: %s", e.what());
+    } catch (...) {
+        Rf_error("updateVariable unknown error");
+    }
+}
+extern "C" SEXP C_readVariable(SEXP name_spaceSEXP, SEXP varnameSEXP, SEXP rowsSEXP, SEXP colsSEXP, SEXP timeoutSEXP) {
+    try {
+        return readVariable(as<std::string>(name_spaceSEXP), as<std::string>(varnameSEXP), rowsSEXP, colsSEXP,
+                            as<double>(timeoutSEXP));
+    } catch (std::exception &e) {
+        Rf_error("readVariable error: %s", e.what());
+    } catch (...) {
+        Rf_error("readVariable unknown error");
+    }
+}
+extern "C" SEXP C_variableVersion(SEXP name_spaceSEXP, SEXP varnameSEXP) {
+    try {
+        return wrap(variableVersion(as<std::string>(name_spaceSEXP), as<std::string>(varnameSEXP)));
+    } catch (std::exception &e) {
+        Rf_error("variableVersion error: %s", e.what());
+    } catch (...) {
+        Rf_error("variableVersion unknown error");
+    }
+}
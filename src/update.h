@@ -0,0 +1,42 @@
+#pragma once
+#include <Rcpp.h>
+
+using namespace Rcpp;
+
+/**
+ * Overwrites a part of a variable owned by the current process in place, bracketed by the seqlock of its segment
+ * (see segment_header.h), so that views in all processes see the change without re-attaching.
+ * 
+ * @param name_space        A string identifying the memory space we are working in.
+ * @param varname           The name of a matrix or vector owned by the current process.
+ * @param value             The new values: length(rows) * length(cols) values in column-major order, or one value for all.
+ * @param rows              1-based row indices of a matrix or element indices of a vector; NULL for all.
+ * @param cols              1-based column indices of a matrix; NULL for all.
+ * @param offset            Vectors only: 1-based position the values are written to contiguously; NA if rows is used.
+ */
+void updateVariable(std::string name_space, std::string varname, NumericVector value, SEXP rows, SEXP cols, double offset);
+
+/**
+ * Copies a part of a shared matrix or vector into a new R object; reads that overlap an update are retried, hence the
+ * result is never torn.
+ * 
+ * @param name_space        A string identifying the memory space we are working in.
+ * @param varname           The name of the matrix or vector.
+ * @param rows, cols        1-based indices as in updateVariable; NULL for all.
+ * @param timeout           Seconds to wait for an update in progress.
+ * 
+ * @result  A matrix (vector) of the selected rows and columns (elements).
+ */
+SEXP readVariable(std::string name_space, std::string varname, SEXP rows, SEXP cols, double timeout);
+
+/**
+ * The number of in-place updates a variable has seen so far; NA while an update is in progress.
+ */
+double variableVersion(std::string name_space, std::string varname);
+
+/**
+ * Wrapper functions for updateVariable, readVariable and variableVersion above.
+ */
+extern "C" SEXP C_updateVariable(SEXP name_spaceSEXP, SEXP varnameSEXP, SEXP valueSEXP, SEXP rowsSEXP, SEXP colsSEXP, SEXP offsetSEXP);
+extern "C" SEXP C_readVariable(SEXP name_spaceSEXP, SEXP varnameSEXP, SEXP rowsSEXP, SEXP colsSEXP, SEXP timeoutSEXP);
+extern "C" SEXP C_variableVersion(SEXP name_spaceSEXP, SEXP varnameSEXP);